@@ -0,0 +1,324 @@
+// Throughput benchmarks. Build and run like main.cpp:
+//
+//   g++ -std=c++17 -O2 -pthread benchmark.cpp includes/*.cpp -o benchmark
+//   ./benchmark [--suite clock|state|run] [--events N] [--repeat N] [--quick] [--stats] [--sample RATE]
+//               [--workers N]
+//
+// With --stats, a build with -DDETECTOR_STATS also dumps the hot-path
+// counters of the whole session to stderr at the end. With --sample, the
+// run suite also times sampled runs down to RATE and reports their coverage.
+// With --workers, it also times runs split across N worker threads and
+// checks that they find the same races as the sequential run.
+//
+// Each result is printed as one JSON object per line, so runs can be
+// diffed or loaded into a spreadsheet to spot regressions.
+#include "includes/run.h"
+#include "includes/detector.h"
+#include "includes/workload.h"
+#include "includes/stats.h"
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    std::string suite;
+    std::size_t events = std::size_t(1) << 20;
+    int repeat = 3;
+    bool stats = false;
+    double sampleRate = 0;
+    int workers = 1;
+};
+
+// Keeps the optimizer from dropping the measured work
+volatile long sink;
+
+// Best wall time of repeat runs of body, in seconds. setup runs before each
+// repeat and is not timed.
+double bestOf(int repeat, const std::function<void()>& setup, const std::function<void()>& body) {
+    double best = 0;
+    for (int i = 0; i < repeat; ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+// One result line
+class Json {
+    std::ostringstream os;
+    bool first = true;
+
+    std::ostringstream& key(const char* name) {
+        os << (first ? "{" : ", ") << '"' << name << "\": ";
+        first = false;
+        return os;
+    }
+public:
+    Json& add(const char* name, const std::string& value) { key(name) << '"' << value << '"'; return *this; }
+    Json& add(const char* name, const char* value) { return add(name, std::string(value)); }
+    Json& add(const char* name, double value) { key(name) << value; return *this; }
+    Json& add(const char* name, long long value) { key(name) << value; return *this; }
+    Json& add(const char* name, int value) { return add(name, static_cast<long long>(value)); }
+    Json& add(const char* name, long value) { return add(name, static_cast<long long>(value)); }
+    Json& add(const char* name, std::size_t value) { return add(name, static_cast<long long>(value)); }
+    void print() { std::cout << os.str() << "}" << std::endl; }
+};
+
+void clockSuite(const BenchOptions& options) {
+    const long ops = static_cast<long>(options.events);
+    for (int width : {4, 16, 64, 256}) {
+        VectorClock a(width), b(width);
+        for (int i = 0; i < width; ++i) {
+            a[i] = i % 7;
+            b[i] = i % 5;
+        }
+        auto report = [&](const char* op, double seconds) {
+            Json().add("suite", "clock").add("op", op).add("width", width).add("ops", ops)
+                  .add("ns_per_op", seconds * 1e9 / ops).print();
+        };
+
+        report("join", bestOf(options.repeat, [] {}, [&] {
+            for (long i = 0; i < ops; ++i) {
+                a.joinInto(b);
+                b.increment(static_cast<int>(i % width));
+            }
+            sink = b[0];
+        }));
+        report("compare", bestOf(options.repeat, [] {}, [&] {
+            long count = 0;
+            for (long i = 0; i < ops; ++i) {
+                count += a <= b;
+                b.increment(static_cast<int>(i % width));
+            }
+            sink = count;
+        }));
+        report("find_greater", bestOf(options.repeat, [] {}, [&] {
+            long count = 0;
+            for (long i = 0; i < ops; ++i) {
+                count += b.findGreater(a);
+                a.increment(static_cast<int>(i % width));
+            }
+            sink = count;
+        }));
+        report("assign", bestOf(options.repeat, [] {}, [&] {
+            for (long i = 0; i < ops; ++i) {
+                b.assignFrom(a);
+                a.increment(static_cast<int>(i % width));
+            }
+            sink = b[0];
+        }));
+    }
+}
+
+void stateSuite(const BenchOptions& options) {
+    const long ops = static_cast<long>(options.events);
+    const int threads = 64, objects = 1024;
+    auto state = initialVectorClockState(threads);
+    std::vector<std::string> lockNames, locationNames;
+    for (int i = 0; i < objects; ++i) {
+        lockNames.push_back("m" + std::to_string(i));
+        locationNames.push_back("x" + std::to_string(i));
+        state.addLock(lockNames.back());
+        state.locationId(locationNames.back());
+    }
+    auto report = [&](const char* op, double seconds) {
+        Json().add("suite", "state").add("op", op).add("threads", threads).add("objects", objects)
+              .add("ops", ops).add("ns_per_op", seconds * 1e9 / ops).print();
+    };
+
+    report("get_c", bestOf(options.repeat, [] {}, [&] {
+        long sum = 0;
+        for (long i = 0; i < ops; ++i) {
+            sum += state.getC(static_cast<int>(i % threads))[0];
+        }
+        sink = sum;
+    }));
+    report("lock_id", bestOf(options.repeat, [] {}, [&] {
+        long sum = 0;
+        for (long i = 0; i < ops; ++i) {
+            sum += state.lockId(lockNames[i % objects]);
+        }
+        sink = sum;
+    }));
+    report("location_id", bestOf(options.repeat, [] {}, [&] {
+        long sum = 0;
+        for (long i = 0; i < ops; ++i) {
+            sum += state.locationId(locationNames[i % objects]);
+        }
+        sink = sum;
+    }));
+    report("get_rw", bestOf(options.repeat, [] {}, [&] {
+        long sum = 0;
+        for (long i = 0; i < ops; ++i) {
+            const int id = static_cast<int>((i * 7) % objects);
+            sum += state.getW(id).clock + state.getR(id).epoch.clock;
+        }
+        sink = sum;
+    }));
+}
+
+// End-to-end events per second of one workload on each state kind
+void runWorkload(const BenchOptions& options, WorkloadConfig config) {
+    config.events = options.events;
+    RunOptions runOptions;
+    runOptions.collectAll = true;
+    runOptions.maxRacesPerLocation = 1;
+
+    auto report = [&](const char* state, const std::vector<Event>& events, double seconds, std::size_t races) {
+        Json().add("suite", "run").add("state", state).add("threads", config.threads)
+              .add("locations", config.locations).add("locks", config.locks).add("atomics", config.atomics)
+              .add("sync_ratio", config.syncRatio).add("atomic_ratio", config.atomicRatio)
+              .add("sharing", sharingName(config.sharing)).add("events", events.size())
+              .add("seconds", seconds).add("events_per_sec", events.size() / seconds)
+              .add("races", races).print();
+    };
+
+    {
+        auto base = initialVectorClockState(config.threads);
+        const std::vector<Event> events = generateWorkload(base, config);
+        VectorClockState state = base;
+        RunResult result;
+        double seconds = bestOf(options.repeat, [&] { state = base; },
+                                [&] { result = run(state, events, runOptions); });
+        report("vectorclock", events, seconds, result.races.size());
+
+        if (options.workers > 1) {
+            RunOptions parallelOptions = runOptions;
+            parallelOptions.workers = static_cast<unsigned>(options.workers);
+            RunResult parallel;
+            seconds = bestOf(options.repeat, [&] { state = base; },
+                             [&] { parallel = run(state, events, parallelOptions); });
+            Json().add("suite", "run").add("state", "vectorclock-parallel").add("threads", config.threads)
+                  .add("sharing", sharingName(config.sharing)).add("events", events.size())
+                  .add("workers", options.workers)
+                  .add("seconds", seconds).add("events_per_sec", events.size() / seconds)
+                  .add("races", parallel.races.size()).add("same_races", parallel.races == result.races ? 1 : 0).print();
+        }
+
+        if (options.sampleRate > 0) {
+            RunOptions sampledOptions = runOptions;
+            std::unique_ptr<Sampler> sampler;
+            seconds = bestOf(options.repeat, [&] {
+                state = base;
+                sampler = std::make_unique<Sampler>(options.sampleRate);
+                sampledOptions.sampler = sampler.get();
+            }, [&] { result = run(state, events, sampledOptions); });
+            Json().add("suite", "run").add("state", "vectorclock-sampled").add("threads", config.threads)
+                  .add("sharing", sharingName(config.sharing)).add("events", events.size())
+                  .add("sample_rate", options.sampleRate).add("coverage", sampler->coverage())
+                  .add("seconds", seconds).add("events_per_sec", events.size() / seconds)
+                  .add("races", result.races.size()).print();
+        }
+    }
+
+    using Factory = std::unique_ptr<Detector> (*)(int, const std::vector<std::string>&,
+                                                  const std::vector<std::string>&, const std::vector<std::string>&);
+    const std::pair<const char*, Factory> detectors[] = {
+        {"detector", makeDetector},
+        {"treeclock", makeTreeClockDetector},
+    };
+    for (const auto& [name, make] : detectors) {
+        std::unique_ptr<Detector> detector;
+        std::vector<Event> events;
+        RunResult result;
+        double seconds = bestOf(options.repeat, [&] {
+            detector = make(config.threads, {}, {}, {});
+            events = generateWorkload(*detector, config);
+        }, [&] { result = detector->run(events, runOptions); });
+        report(name, events, seconds, result.races.size());
+    }
+}
+
+void runSuite(const BenchOptions& options) {
+    for (Sharing sharing : {Sharing::Private, Sharing::Uniform, Sharing::ReadMostly, Sharing::LockProtected}) {
+        for (int threads : {4, 64}) {
+            WorkloadConfig config;
+            config.threads = threads;
+            config.sharing = sharing;
+            runWorkload(options, config);
+        }
+    }
+
+    // Lock contention, synchronization-heavy and atomic-heavy traces
+    for (int locks : {1, 256}) {
+        WorkloadConfig config;
+        config.locks = locks;
+        config.syncRatio = 0.3;
+        config.sharing = Sharing::LockProtected;
+        runWorkload(options, config);
+    }
+    WorkloadConfig atomicHeavy;
+    atomicHeavy.syncRatio = 0.5;
+    atomicHeavy.atomicRatio = 0.9;
+    runWorkload(options, atomicHeavy);
+
+    // Rare sync events: nearly all the time goes to the access checks that
+    // --workers splits, so this is the case it speeds up the most
+    WorkloadConfig accessHeavy;
+    accessHeavy.threads = 64;
+    accessHeavy.syncRatio = 0.001;
+    accessHeavy.sharing = Sharing::Uniform;
+    runWorkload(options, accessHeavy);
+}
+
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--suite" && i + 1 < argc) {
+            options.suite = argv[++i];
+        } else if (arg == "--events" && i + 1 < argc) {
+            options.events = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = std::atoi(argv[++i]);
+        } else if (arg == "--sample" && i + 1 < argc) {
+            options.sampleRate = std::atof(argv[++i]);
+        } else if (arg == "--workers" && i + 1 < argc) {
+            options.workers = std::atoi(argv[++i]);
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--quick") {
+            options.events = std::size_t(1) << 16;
+            options.repeat = 1;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--suite clock|state|run] [--events N] [--repeat N] [--quick] [--stats] [--sample RATE]"
+                      << " [--workers N]" << std::endl;
+            return 2;
+        }
+    }
+    if (options.events == 0 || options.repeat < 1 || options.workers < 1) {
+        std::cerr << "--events, --repeat and --workers must be positive" << std::endl;
+        return 2;
+    }
+    if (options.sampleRate < 0 || options.sampleRate > 1) {
+        std::cerr << "--sample must be in (0, 1]" << std::endl;
+        return 2;
+    }
+
+    if (options.suite.empty() || options.suite == "clock") {
+        clockSuite(options);
+    }
+    if (options.suite.empty() || options.suite == "state") {
+        stateSuite(options);
+    }
+    if (options.suite.empty() || options.suite == "run") {
+        runSuite(options);
+    }
+    if (options.stats) {
+        std::cerr << collectStats();
+    }
+    return 0;
+}
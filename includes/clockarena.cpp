@@ -0,0 +1,133 @@
+#include "clockarena.h"
+#include "clockkernels.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+static int* allocateBlock(std::size_t entries) {
+    return static_cast<int*>(::operator new(entries * sizeof(int), std::align_val_t(CLOCK_ALIGNMENT)));
+}
+
+static void freeBlock(int* block) {
+    ::operator delete(block, std::align_val_t(CLOCK_ALIGNMENT));
+}
+
+ClockArena::ClockArena(int width) : clockWidth(width), rowStride(paddedWidth(width)) {}
+
+ClockArena::ClockArena(const ClockArena& other)
+    : clockWidth(other.clockWidth), rowStride(other.rowStride), freeRows(other.freeRows) {
+    reserve(other.rowsUsed);
+    rowsUsed = other.rowsUsed;
+    if (bytes() > 0) {
+        std::memcpy(base, other.base, bytes());
+    }
+}
+
+ClockArena::ClockArena(ClockArena&& other) noexcept
+    : base(other.base), clockWidth(other.clockWidth), rowStride(other.rowStride),
+      rowsUsed(other.rowsUsed), rowsReserved(other.rowsReserved), freeRows(std::move(other.freeRows)) {
+    other.base = nullptr;
+    other.rowsUsed = 0;
+    other.rowsReserved = 0;
+}
+
+ClockArena& ClockArena::operator=(const ClockArena& other) {
+    if (this != &other) {
+        ClockArena copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+ClockArena& ClockArena::operator=(ClockArena&& other) noexcept {
+    if (this != &other) {
+        release();
+        base = other.base;
+        clockWidth = other.clockWidth;
+        rowStride = other.rowStride;
+        rowsUsed = other.rowsUsed;
+        rowsReserved = other.rowsReserved;
+        freeRows = std::move(other.freeRows);
+        other.base = nullptr;
+        other.rowsUsed = 0;
+        other.rowsReserved = 0;
+    }
+    return *this;
+}
+
+ClockArena::~ClockArena() {
+    release();
+}
+
+// Grow geometrically so that allocating rows one at a time stays amortized O(1)
+void ClockArena::reserve(std::size_t rows) {
+    if (rows <= rowsReserved) {
+        return;
+    }
+    std::size_t grown = std::max(rows, std::max<std::size_t>(rowsReserved * 2, 8));
+    int* block = allocateBlock(grown * rowStride);
+    if (base) {
+        std::memcpy(block, base, bytes());
+        freeBlock(base);
+    }
+    base = block;
+    rowsReserved = grown;
+}
+
+int ClockArena::allocate() {
+    if (!freeRows.empty()) {
+        int index = freeRows.back();
+        freeRows.pop_back();
+        return index;
+    }
+    reserve(rowsUsed + 1);
+    std::fill(base + rowsUsed * rowStride, base + (rowsUsed + 1) * rowStride, 0);
+    return static_cast<int>(rowsUsed++);
+}
+
+void ClockArena::free(int row) {
+    std::fill(base + row * rowStride, base + (row + 1) * rowStride, 0);
+    freeRows.push_back(row);
+}
+
+void ClockArena::widen(int width) {
+    if (width <= clockWidth) {
+        return;
+    }
+    std::size_t stride = paddedWidth(width);
+    if (stride > rowStride) {
+        stride = std::max(stride, rowStride * 2);
+        if (base) {
+            int* block = allocateBlock(rowsReserved * stride);
+            for (std::size_t r = 0; r < rowsUsed; ++r) {
+                std::copy(base + r * rowStride, base + (r + 1) * rowStride, block + r * stride);
+                std::fill(block + r * stride + rowStride, block + (r + 1) * stride, 0);
+            }
+            freeBlock(base);
+            base = block;
+        }
+        rowStride = stride;
+    }
+    clockWidth = width;
+}
+
+void ClockArena::reset() {
+    std::fill(base, base + rowsUsed * rowStride, 0);
+}
+
+void ClockArena::clear() {
+    rowsUsed = 0;
+    freeRows.clear();
+}
+
+void ClockArena::release() {
+    if (base) {
+        freeBlock(base);
+    }
+    base = nullptr;
+    rowsUsed = 0;
+    rowsReserved = 0;
+    freeRows.clear();
+}
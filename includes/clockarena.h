@@ -0,0 +1,135 @@
+#ifndef CLOCKARENA_H
+#define CLOCKARENA_H
+
+#include "clockkernels.h"
+#include "stats.h"
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// View of one vector clock stored as a row of a ClockArena. Offers the same
+// operations as VectorClock; writes go straight to the arena. A view is
+// invalidated when the arena allocates a new row or is widened.
+template <typename T>
+class BasicClockRow {
+    T* entries;
+    int width;
+    int stride;
+
+    template <typename U> friend class BasicClockRow;
+public:
+    BasicClockRow(T* entries, int width, int stride) : entries(entries), width(width), stride(stride) {}
+
+    // A mutable row converts to a read-only one
+    template <typename U>
+    BasicClockRow(const BasicClockRow<U>& other) : entries(other.entries), width(other.width), stride(other.stride) {}
+
+    int size() const { return width; }
+    T* data() const { return entries; }
+
+    T& operator[](size_t index) const { return entries[index]; }
+
+    const BasicClockRow& increment(int index) const {
+        if (index >= 0 && index < width) {
+            entries[index]++;
+        }
+        return *this;
+    }
+
+    bool operator<=(const BasicClockRow<const int>& other) const {
+        assert(stride == other.stride);
+        return clockLeq(entries, other.entries, stride);
+    }
+
+    // In-place join target := max(target, *this)
+    void joinInto(const BasicClockRow<int>& target) const {
+        assert(stride == target.stride);
+        clockJoin(target.entries, entries, stride);
+    }
+
+    // Overwrite with other's entries
+    void assignFrom(const BasicClockRow<const int>& other) const {
+        assert(stride == other.stride);
+        DETECTOR_STAT(countClockOp(Counter::Copies, stride));
+        std::copy(other.entries, other.entries + stride, entries);
+    }
+
+    // Smallest index whose entry exceeds other's, or -1 if *this <= other
+    int findGreater(const BasicClockRow<const int>& other) const {
+        assert(stride == other.stride);
+        return clockFindGreater(entries, other.entries, stride);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const BasicClockRow& row) {
+        os << '[';
+        for (int i = 0; i < row.width; i++) {
+            os << row.entries[i];
+            if (i < row.width - 1) os << ", ";
+        }
+        os << ']';
+        return os;
+    }
+};
+
+using ClockRow = BasicClockRow<int>;
+using ConstClockRow = BasicClockRow<const int>;
+
+// One contiguous, CLOCK_ALIGNMENT-aligned block holding equally wide vector
+// clocks as rows of a matrix. Rows are addressed by index, and freed rows
+// are recycled. widen() adds entries to every row as clock slots appear;
+// it reallocates the block when the stride grows, so, like allocate(), it
+// invalidates row views but not row indices. Because every clock of a
+// state lives in the same block, copying or snapshotting it is a single
+// memcpy and resetting it a single fill.
+class ClockArena {
+    int* base = nullptr;
+    int clockWidth = 0;
+    std::size_t rowStride = 0;    // padded entries per row
+    std::size_t rowsUsed = 0;     // high-water mark of allocated rows
+    std::size_t rowsReserved = 0;
+    std::vector<int> freeRows;
+
+    void reserve(std::size_t rows);
+public:
+    explicit ClockArena(int width = 0);
+    ClockArena(const ClockArena& other);
+    ClockArena(ClockArena&& other) noexcept;
+    ClockArena& operator=(const ClockArena& other);
+    ClockArena& operator=(ClockArena&& other) noexcept;
+    ~ClockArena();
+
+    int width() const { return clockWidth; }
+    std::size_t stride() const { return rowStride; }
+    std::size_t rows() const { return rowsUsed; }
+
+    // A new zeroed row, reusing a freed one if possible
+    int allocate();
+    // Return a row to the arena; its entries are zeroed for reuse
+    void free(int row);
+
+    // Grow every row to at least width entries; new entries are zero. The
+    // stride at least doubles when it has to change, so widening one thread
+    // at a time stays amortized O(1) per row.
+    void widen(int width);
+
+    ClockRow row(int index) {
+        return ClockRow(base + index * rowStride, clockWidth, static_cast<int>(rowStride));
+    }
+    ConstClockRow row(int index) const {
+        return ConstClockRow(base + index * rowStride, clockWidth, static_cast<int>(rowStride));
+    }
+
+    // Zero every entry, keeping all rows allocated
+    void reset();
+    // Drop all rows but keep the memory for reuse
+    void clear();
+    // Drop all rows and give the memory back
+    void release();
+
+    // Raw contents of the rows in use, for snapshots
+    const int* data() const { return base; }
+    std::size_t bytes() const { return rowsUsed * rowStride * sizeof(int); }
+};
+
+#endif
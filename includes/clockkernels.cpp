@@ -0,0 +1,155 @@
+#include "clockkernels.h"
+#include "stats.h"
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CLOCK_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// Scalar fallback
+// ----------------------------------------------------------------------------
+
+static void joinScalar(int* dst, const int* src, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        dst[i] = std::max(dst[i], src[i]);
+    }
+}
+
+static bool leqScalar(const int* a, const int* b, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (a[i] > b[i]) return false;
+    }
+    return true;
+}
+
+static int findGreaterScalar(const int* a, const int* b, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (a[i] > b[i]) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+#ifdef CLOCK_KERNELS_X86
+
+// ----------------------------------------------------------------------------
+// AVX2: 8 entries per step
+// ----------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void joinAvx2(int* dst, const int* src, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 8) {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_max_epi32(a, b));
+    }
+}
+
+__attribute__((target("avx2")))
+static bool leqAvx2(const int* a, const int* b, std::size_t n) {
+    __m256i any = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < n; i += 8) {
+        __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_load_si256(reinterpret_cast<const __m256i*>(b + i));
+        any = _mm256_or_si256(any, _mm256_cmpgt_epi32(x, y));
+    }
+    return _mm256_testz_si256(any, any);
+}
+
+__attribute__((target("avx2")))
+static int findGreaterAvx2(const int* a, const int* b, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 8) {
+        __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_load_si256(reinterpret_cast<const __m256i*>(b + i));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, y)));
+        if (mask) return static_cast<int>(i) + __builtin_ctz(mask);
+    }
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+// SSE4.1: 4 entries per step (two per CLOCK_LANES block)
+// ----------------------------------------------------------------------------
+
+__attribute__((target("sse4.1")))
+static void joinSse4(int* dst, const int* src, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 4) {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst + i), _mm_max_epi32(a, b));
+    }
+}
+
+__attribute__((target("sse4.1")))
+static bool leqSse4(const int* a, const int* b, std::size_t n) {
+    __m128i any = _mm_setzero_si128();
+    for (std::size_t i = 0; i < n; i += 4) {
+        __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_load_si128(reinterpret_cast<const __m128i*>(b + i));
+        any = _mm_or_si128(any, _mm_cmpgt_epi32(x, y));
+    }
+    return _mm_testz_si128(any, any);
+}
+
+__attribute__((target("sse4.1")))
+static int findGreaterSse4(const int* a, const int* b, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 4) {
+        __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_load_si128(reinterpret_cast<const __m128i*>(b + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, y)));
+        if (mask) return static_cast<int>(i) + __builtin_ctz(mask);
+    }
+    return -1;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Runtime dispatch
+// ----------------------------------------------------------------------------
+
+struct ClockKernels {
+    void (*join)(int*, const int*, std::size_t);
+    bool (*leq)(const int*, const int*, std::size_t);
+    int (*findGreater)(const int*, const int*, std::size_t);
+    const char* name;
+};
+
+static ClockKernels selectKernels() {
+#ifdef CLOCK_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {joinAvx2, leqAvx2, findGreaterAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return {joinSse4, leqSse4, findGreaterSse4, "sse4.1"};
+    }
+#endif
+    return {joinScalar, leqScalar, findGreaterScalar, "scalar"};
+}
+
+static const ClockKernels& kernels() {
+    static const ClockKernels selected = selectKernels();
+    return selected;
+}
+
+void clockJoin(int* dst, const int* src, std::size_t n) {
+    DETECTOR_STAT(countClockOp(Counter::Joins, n));
+    kernels().join(dst, src, n);
+}
+
+bool clockLeq(const int* a, const int* b, std::size_t n) {
+    DETECTOR_STAT(countClockOp(Counter::Compares, n));
+    return kernels().leq(a, b, n);
+}
+
+int clockFindGreater(const int* a, const int* b, std::size_t n) {
+    DETECTOR_STAT(countClockOp(Counter::Compares, n));
+    return kernels().findGreater(a, b, n);
+}
+
+const char* clockKernelName() {
+    return kernels().name;
+}
@@ -0,0 +1,32 @@
+#ifndef CLOCKKERNELS_H
+#define CLOCKKERNELS_H
+
+#include <cstddef>
+
+// Hot loops over raw vector clock entries. Every buffer passed in must be
+// CLOCK_ALIGNMENT-byte aligned and n a multiple of CLOCK_LANES, with unused
+// padding entries kept at zero, so the SIMD paths never need a scalar tail.
+// The implementation (AVX2, SSE4.1 or scalar) is picked once at startup
+// from the CPU the process runs on.
+
+constexpr std::size_t CLOCK_LANES = 8;
+constexpr std::size_t CLOCK_ALIGNMENT = 32;
+
+// Round a clock width up to the padded storage width
+constexpr std::size_t paddedWidth(std::size_t n) {
+    return (n + CLOCK_LANES - 1) / CLOCK_LANES * CLOCK_LANES;
+}
+
+// dst[i] = max(dst[i], src[i])
+void clockJoin(int* dst, const int* src, std::size_t n);
+
+// a[i] <= b[i] for every i
+bool clockLeq(const int* a, const int* b, std::size_t n);
+
+// Smallest i with a[i] > b[i], or -1 if a <= b
+int clockFindGreater(const int* a, const int* b, std::size_t n);
+
+// Name of the selected implementation, for diagnostics
+const char* clockKernelName();
+
+#endif
@@ -0,0 +1,366 @@
+#ifndef DETECT_H
+#define DETECT_H
+
+#include "instructions.h"
+#include "event.h"
+#include "race.h"
+#include "epoch.h"
+#include "symboltable.h"
+#include "stats.h"
+#include "tracelog.h"
+#include "racefilter.h"
+#include "sampler.h"
+#include <vector>
+#include <iostream>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+// The detection engine, written once against the shadow-state interface
+// shared by VectorClockState (arena-backed, any thread count),
+// StaticVectorClockState<N> (thread count fixed at compile time) and
+// TreeClockState (tree clocks for threads and locks). Epochs and clock
+// entries are indexed by the state's clock slots, which threadOf() maps
+// back to thread IDs.
+
+struct RunOptions {
+    bool verbose = false;
+    // Keep going after a race, updating the shadow state as if the racy
+    // access had been ordered, instead of stopping at the first one
+    bool collectAll = false;
+    // Collect-all caps; 0 means unlimited. Analysis stops once maxRaces races
+    // are recorded; races past maxRacesPerLocation on one location are dropped.
+    std::size_t maxRaces = 0;
+    std::size_t maxRacesPerLocation = 0;
+    // Above 1, Read/Write checks are sharded by location across this many
+    // threads (see parallel.h); verbose runs always use one
+    unsigned workers = 1;
+    // If set, each event's changes are logged here instead (see tracelog.h);
+    // like verbose, this keeps the run on one thread
+    TraceLog* log = nullptr;
+    // Report a race only the first time its key is seen (see racefilter.h)
+    RaceKey dedupe = RaceKey::None;
+    // Benign locations: never reported, and with skipChecks not checked
+    Suppressions* suppress = nullptr;
+    // If set, only the Read/Write checks it picks are run (see sampler.h)
+    Sampler* sampler = nullptr;
+};
+
+// Outcome of a run. The analysed shadow state is left in the caller's
+// VectorClockState; only the races and the stopping point are returned.
+struct RunResult {
+    std::vector<Race> races;
+    // Number of events analysed. If stopped is set, this is the index of the
+    // event whose race ended the run; its shadow update was not applied.
+    std::size_t position = 0;
+    bool stopped = false;
+    // Per-location race counts, kept for RunOptions::maxRacesPerLocation
+    std::vector<std::size_t> racesPerLocation;
+    // Keys of the races reported so far, kept for RunOptions::dedupe
+    RaceSet seen;
+};
+
+template <typename ReadClock, typename ThreadClock>
+int findRacyThread(const ReadClock& location_vec, const ThreadClock& clock_vec) {
+    int u = location_vec.findGreater(clock_vec);  // Slot of the racy thread
+
+    // If no racy thread is found, throw an exception
+    if (u < 0) {
+        throw std::runtime_error("Could not find racy thread");
+    }
+    return u;
+}
+
+// Lowest thread ID among the reads of a read-shared clock that race with
+// clock. A slot only holds its latest reader, so with recycled slots an
+// earlier racy reader on the same slot may not be named.
+template <typename State, typename ReadClock, typename ThreadClock>
+int findRacyReader(const State& state, const ReadClock& reads, const ThreadClock& clock) {
+    int u = findRacyThread(reads, clock);
+    int reader = state.threadOf(Epoch(u, reads[u]));
+    for (++u; u < static_cast<int>(reads.size()); ++u) {
+        if (reads[u] > clock[u]) {
+            reader = std::min(reader, state.threadOf(Epoch(u, reads[u])));
+        }
+    }
+    return reader;
+}
+
+// Verbose-mode rendering of an event, in Instruction::toString() syntax
+template <typename State>
+std::string describe(const State& state, const Event& ev) {
+    std::string prefix = std::string(opcodeName(ev.op)) + "(" + std::to_string(ev.thread) + ", ";
+    if (isThreadOp(ev.op)) {
+        return prefix + std::to_string(ev.object) + ")";
+    }
+    const SymbolTable& names = isAccess(ev.op) ? state.locations() : state.locks();
+    return prefix + names.name(static_cast<int>(ev.object)) + ")";
+}
+
+// Intern the names and threads used by program into state and encode it as
+// compact events
+template <typename State>
+std::vector<Event> lowerProgram(State& state, const std::vector<std::shared_ptr<Instruction>>& program) {
+    std::vector<Event> events;
+    events.reserve(program.size());
+    for (const auto& instr : program) {
+        const Opcode op = instr->getOpcode();
+        const std::string& x = instr->getLocation();
+        state.addThread(instr->getThreadId());
+
+        int id;
+        switch (op) {
+        case Opcode::Read: {
+            const auto& read = static_cast<const Read&>(*instr);
+            id = read.hasAddress() ? state.addressId(read.getAddress()) : state.locationId(x);
+            break;
+        }
+        case Opcode::Write: {
+            const auto& write = static_cast<const Write&>(*instr);
+            id = write.hasAddress() ? state.addressId(write.getAddress()) : state.locationId(x);
+            break;
+        }
+        case Opcode::Fork:
+            id = state.addThread(static_cast<const Fork&>(*instr).getChildId());
+            break;
+        case Opcode::Join:
+            id = state.addThread(static_cast<const Join&>(*instr).getChildId());
+            break;
+        default:
+            // A lock or atomic nobody has released yet has the zero clock
+            id = state.addLock(x);
+            break;
+        }
+        events.push_back(Event{op, static_cast<std::uint32_t>(instr->getThreadId()), static_cast<std::uint64_t>(id)});
+    }
+    return events;
+}
+
+// Record a race found while executing ev. Returns true if analysis should
+// stop: always in first-race mode, and in collect-all mode once the overall
+// cap is reached. Races beyond the per-location cap are dropped silently.
+template <typename State>
+bool report(const State& state, const Event& ev, const Race& race, const RunOptions& options, RunResult& result) {
+    if (options.suppress && options.suppress->contains(race.location)) {
+        return false;
+    }
+    if (options.dedupe != RaceKey::None && !result.seen.insert(race, options.dedupe)) {
+        return false;
+    }
+    if (options.maxRacesPerLocation > 0) {
+        if (race.location >= static_cast<int>(result.racesPerLocation.size())) {
+            result.racesPerLocation.resize(race.location + 1, 0);
+        }
+        if (result.racesPerLocation[race.location] >= options.maxRacesPerLocation) {
+            return false;
+        }
+        ++result.racesPerLocation[race.location];
+    }
+    if (options.verbose) {
+        std::cout << "!!! ";
+        race.print(std::cout, state.locations());
+        std::cout << " when executing " << describe(state, ev) << " !!!" << std::endl;
+    }
+    if (options.log) {
+        options.log->race(state, race, result.position);
+    }
+    result.races.push_back(race);
+    if (!options.collectAll) {
+        return true;
+    }
+    return options.maxRaces > 0 && result.races.size() >= options.maxRaces;
+}
+
+// Outcome of checking one access
+enum class Step {
+    Done,       // shadow updated
+    SameEpoch,  // nothing to do, the thread already made this access
+    Stop,       // a race ended the analysis; the shadow was not updated
+};
+
+// Accesses to suppressed locations are skipped entirely with skipChecks
+inline bool unchecked(const RunOptions& options, int location) {
+    return options.suppress && options.suppress->skipChecks() && options.suppress->contains(location);
+}
+
+// Sampling runs check only the accesses the sampler picks
+inline bool sampled(const RunOptions& options, const Event& ev) {
+    return !options.sampler || options.sampler->sample(static_cast<int>(ev.thread), static_cast<int>(ev.object));
+}
+
+// Check a read of location ev.object by thread ev.thread and update its shadow
+template <typename State>
+Step detectRead(State& state, const Event& ev, const RunOptions& options, RunResult& result) {
+    const int t = static_cast<int>(ev.thread);
+    const int id = static_cast<int>(ev.object);
+    if (unchecked(options, id)) {
+        return Step::SameEpoch;
+    }
+    auto& r = state.getR(id);
+    const Epoch e = state.epoch(t);
+
+    // Same epoch: this thread already read x since its last release
+    if (r.isShared() ? state.sharedRead(r)[e.thread] == e.clock : r.epoch == e) {
+        return Step::SameEpoch;
+    }
+
+    const Epoch& w = state.getW(id);
+    if (!(w <= state.getC(t))) {
+        if (report(state, ev, Race{RaceType::WriteRead, state.threadOf(w), t, id}, options, result)) {
+            return Step::Stop;
+        }
+    }
+
+    if (r.isShared()) {
+        state.sharedRead(r)[e.thread] = e.clock;
+    } else if (r.epoch <= state.getC(t)) {
+        r.epoch = e;
+    } else {
+        state.inflate(r, e);
+    }
+    return Step::Done;
+}
+
+// Check a write of location ev.object by thread ev.thread and update its shadow
+template <typename State>
+Step detectWrite(State& state, const Event& ev, const RunOptions& options, RunResult& result) {
+    const int t = static_cast<int>(ev.thread);
+    const int id = static_cast<int>(ev.object);
+    if (unchecked(options, id)) {
+        return Step::SameEpoch;
+    }
+    const Epoch e = state.epoch(t);
+    const Epoch& w = state.getW(id);
+
+    // Same epoch: this thread already wrote x since its last release
+    if (w == e) {
+        return Step::SameEpoch;
+    }
+
+    if (!(w <= state.getC(t))) {
+        if (report(state, ev, Race{RaceType::WriteWrite, state.threadOf(w), t, id}, options, result)) {
+            return Step::Stop;
+        }
+    }
+
+    auto& r = state.getR(id);
+    bool readOrdered = r.isShared() ? state.sharedRead(r) <= state.getC(t) : r.epoch <= state.getC(t);
+    if (!readOrdered) {
+        int u = r.isShared() ? findRacyReader(state, state.sharedRead(r), state.getC(t)) : state.threadOf(r.epoch);
+        if (report(state, ev, Race{RaceType::ReadWrite, u, t, id}, options, result)) {
+            return Step::Stop;
+        }
+    }
+
+    // Later accesses only need to be ordered against this write: earlier
+    // reads either happen before it or were just reported.
+    if (r.isShared()) {
+        state.collapse(r, Epoch());
+    }
+    state.updateW(id, e);
+    return Step::Done;
+}
+
+// Apply a synchronization event (anything but Read and Write) to C and L
+template <typename State>
+void applySync(State& state, const Event& ev) {
+    const int t = static_cast<int>(ev.thread);
+    const int id = static_cast<int>(ev.object);
+
+    switch (ev.op) {
+    case Opcode::Acquire:
+    case Opcode::AtomicLoad:
+        state.joinLIntoC(id, t);
+        break;
+    case Opcode::Release:
+    case Opcode::AtomicStore:
+        state.assignCToL(t, id);
+        state.tick(t);
+        break;
+    case Opcode::AtomicRMW:
+        // D = max(C[t], L[x]); L[x] = D; C[t] = D, all without temporaries
+        state.joinLIntoC(id, t);
+        state.assignCToL(t, id);
+        state.tick(t);
+        break;
+    case Opcode::Fork:
+        // The child starts after everything the parent has done so far
+        state.forkThread(t, id);
+        break;
+    case Opcode::Join:
+        // Everything the child did happens before the parent continues
+        state.joinThread(t, id);
+        break;
+    default:
+        throw std::invalid_argument("Unknown instruction type");
+    }
+}
+
+// Analyse [begin, end) in place, appending to result
+template <typename State>
+void detectEvents(State& state, const Event* begin, const Event* end, const RunOptions& options, RunResult& result) {
+    if (options.suppress) {
+        options.suppress->update(state.locations());
+    }
+    for (const Event* it = begin; it != end; ++it, ++result.position) {
+        const Event& ev = *it;
+
+        Step step = Step::Done;
+        if (options.log) {
+            options.log->before(state, ev);
+        }
+        {
+            StatEvent stat(ev.op);
+            if (isAccess(ev.op) && !sampled(options, ev)) {
+                step = Step::SameEpoch;
+            } else if (ev.op == Opcode::Read) {
+                step = detectRead(state, ev, options, result);
+            } else if (ev.op == Opcode::Write) {
+                step = detectWrite(state, ev, options, result);
+            } else {
+                applySync(state, ev);
+            }
+        }
+
+        if (step == Step::Stop) {
+            result.stopped = true;
+            return;
+        }
+        if (options.verbose && step == Step::Done) {
+            std::cout << describe(state, ev) << " : " << state << std::endl;
+        }
+        if (options.log) {
+            if (step == Step::Done) {
+                options.log->after(state, ev, result.position);
+            }
+            options.log->snapshot(state, result.position);
+        }
+    }
+}
+
+// Fresh state for num_threads threads with the given objects declared.
+// Declaring is optional: lowering and the trace readers create shadows for
+// threads, locks, atomics and locations on first touch.
+template <typename State>
+State initialState(int num_threads, const std::vector<std::string>& locks = {},
+                                         const std::vector<std::string>& atomic_objects = {},
+                                         const std::vector<std::string>& shared_locations = {}) {
+    State state(num_threads);
+    for (const auto& l : locks) {
+        state.addLock(l);
+    }
+    for (const auto& ao : atomic_objects) {
+        state.addLock(ao);
+    }
+
+    // Read and write shadows start at the bottom epoch 0@0
+    for (const auto& loc : shared_locations) {
+        state.locationId(loc);
+    }
+
+    return state;
+}
+
+#endif
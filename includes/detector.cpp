@@ -0,0 +1,93 @@
+#include "detector.h"
+#include "detect.h"
+#include "parallel.h"
+#include "vectorclockstate.h"
+#include "staticvectorclockstate.h"
+#include "treeclockstate.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+template <typename State>
+class DetectorImpl : public Detector {
+    State state;
+public:
+    explicit DetectorImpl(State s) : state(std::move(s)) {}
+
+    int numThreads() const override { return state.numThreads(); }
+    int clockWidth() const override { return state.clockWidth(); }
+    int addThread(int index) override { return state.addThread(index); }
+
+    int addLock(std::string_view name) override { return state.addLock(name); }
+    int lockId(std::string_view name) const override { return state.lockId(name); }
+    int locationId(std::string_view name) override { return state.locationId(name); }
+    int addressId(std::uint64_t address) override { return state.addressId(address); }
+    void setAddressGranularity(int bytes) override { state.setAddressGranularity(bytes); }
+    int addressGranularity() const override { return state.addressGranularity(); }
+    const SymbolTable& locks() const override { return state.locks(); }
+    const SymbolTable& locations() const override { return state.locations(); }
+
+    std::vector<Event> lower(const std::vector<std::shared_ptr<Instruction>>& program) override {
+        return lowerProgram(state, program);
+    }
+
+    void detect(const Event* begin, const Event* end, const RunOptions& options, RunResult& result) override {
+        if (options.workers > 1) {
+            detectParallel(state, begin, end, options, result);
+        } else {
+            detectEvents(state, begin, end, options, result);
+        }
+    }
+
+    void print(std::ostream& os) const override { os << state; }
+};
+
+template <typename State>
+static std::unique_ptr<Detector> make(int num_threads, const std::vector<std::string>& locks,
+                                      const std::vector<std::string>& atomic_objects,
+                                      const std::vector<std::string>& shared_locations) {
+    return std::make_unique<DetectorImpl<State>>(initialState<State>(num_threads, locks, atomic_objects, shared_locations));
+}
+
+std::unique_ptr<Detector> makeDetector(int num_threads, const std::vector<std::string>& locks,
+                                       const std::vector<std::string>& atomic_objects,
+                                       const std::vector<std::string>& shared_locations) {
+    if (num_threads <= 2)  return make<StaticVectorClockState<2>>(num_threads, locks, atomic_objects, shared_locations);
+    if (num_threads <= 4)  return make<StaticVectorClockState<4>>(num_threads, locks, atomic_objects, shared_locations);
+    if (num_threads <= 8)  return make<StaticVectorClockState<8>>(num_threads, locks, atomic_objects, shared_locations);
+    if (num_threads <= 16) return make<StaticVectorClockState<16>>(num_threads, locks, atomic_objects, shared_locations);
+    if (num_threads <= 32) return make<StaticVectorClockState<32>>(num_threads, locks, atomic_objects, shared_locations);
+    if (num_threads <= 64) return make<StaticVectorClockState<64>>(num_threads, locks, atomic_objects, shared_locations);
+    return make<VectorClockState>(num_threads, locks, atomic_objects, shared_locations);
+}
+
+std::unique_ptr<Detector> makeTreeClockDetector(int num_threads, const std::vector<std::string>& locks,
+                                                const std::vector<std::string>& atomic_objects,
+                                                const std::vector<std::string>& shared_locations) {
+    return make<TreeClockState>(num_threads, locks, atomic_objects, shared_locations);
+}
+
+RunResult Detector::run(const Event* begin, const Event* end, const RunOptions& options) {
+    RunResult result;
+    detect(begin, end, options, result);
+    return result;
+}
+
+RunResult Detector::run(const std::vector<Event>& events, const RunOptions& options) {
+    return run(events.data(), events.data() + events.size(), options);
+}
+
+RunResult Detector::run(const std::vector<std::shared_ptr<Instruction>>& program, const RunOptions& options) {
+    return run(lower(program), options);
+}
+
+std::ostream& operator<<(std::ostream& os, const Detector& detector) {
+    detector.print(os);
+    return os;
+}
+
+void detect(Detector& detector, const Event* begin, const Event* end, const RunOptions& options, RunResult& result) {
+    detector.detect(begin, end, options, result);
+}
@@ -0,0 +1,67 @@
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include "detect.h"
+#include "event.h"
+#include "instructions.h"
+#include "symboltable.h"
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Type-erased detector over a shadow state whose clock representation is
+// chosen at run time. Dispatch is virtual once per call, not per event, so
+// the engine inside runs at the speed of the chosen instantiation.
+class Detector {
+public:
+    virtual ~Detector() {}
+
+    virtual int numThreads() const = 0;
+    // Clock width actually used; the fixed N, or numThreads() when dynamic
+    virtual int clockWidth() const = 0;
+    // Add thread t if missing; fixed-width detectors throw std::out_of_range past N - 1
+    virtual int addThread(int index) = 0;
+
+    virtual int addLock(std::string_view name) = 0;
+    virtual int lockId(std::string_view name) const = 0;
+    virtual int locationId(std::string_view name) = 0;
+    virtual int addressId(std::uint64_t address) = 0;
+    virtual void setAddressGranularity(int bytes) = 0;
+    virtual int addressGranularity() const = 0;
+    virtual const SymbolTable& locks() const = 0;
+    virtual const SymbolTable& locations() const = 0;
+
+    virtual std::vector<Event> lower(const std::vector<std::shared_ptr<Instruction>>& program) = 0;
+    virtual void detect(const Event* begin, const Event* end, const RunOptions& options, RunResult& result) = 0;
+    virtual void print(std::ostream& os) const = 0;
+
+    RunResult run(const Event* begin, const Event* end, const RunOptions& options = RunOptions());
+    RunResult run(const std::vector<Event>& events, const RunOptions& options = RunOptions());
+    RunResult run(const std::vector<std::shared_ptr<Instruction>>& program, const RunOptions& options = RunOptions());
+};
+
+std::ostream& operator<<(std::ostream& os, const Detector& detector);
+
+// Same chunked entry point as detect(VectorClockState&, ...), so code that
+// streams events (e.g. runTextTrace) can drive either
+void detect(Detector& detector, const Event* begin, const Event* end, const RunOptions& options, RunResult& result);
+
+// Build a detector for num_threads threads. Uses the smallest of the
+// StaticVectorClock<N> instantiations (N = 2, 4, 8, 16, 32, 64) that fits,
+// and the dynamic VectorClock beyond that. Traces that fork more threads
+// later should pass the highest thread count they will reach.
+std::unique_ptr<Detector> makeDetector(int num_threads, const std::vector<std::string>& locks = {},
+                                       const std::vector<std::string>& atomic_objects = {},
+                                       const std::vector<std::string>& shared_locations = {});
+
+// Same, but with thread and lock clocks kept as TreeClocks. Acquires and
+// releases then cost time proportional to the entries they change, which
+// pays off with many threads contending on a few locks.
+std::unique_ptr<Detector> makeTreeClockDetector(int num_threads, const std::vector<std::string>& locks = {},
+                                                const std::vector<std::string>& atomic_objects = {},
+                                                const std::vector<std::string>& shared_locations = {});
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include "vectorclock.h"
+#include <iostream>
+#include <memory>
+
+// An epoch c@t is the clock value c of a single thread t. It stands in for a
+// full VectorClock wherever the accesses being tracked are totally ordered,
+// which makes both the comparison and the storage O(1).
+struct Epoch {
+    int thread = 0;
+    int clock = 0;
+
+    Epoch() = default;
+    Epoch(int thread, int clock) : thread(thread), clock(clock) {}
+
+    // c@t <= V  iff  c <= V[t]
+    template <typename Clock>
+    bool operator<=(const Clock& vc) const { return clock <= vc[thread]; }
+    bool operator==(const Epoch& other) const { return thread == other.thread && clock == other.clock; }
+    bool operator!=(const Epoch& other) const { return !(*this == other); }
+
+    friend std::ostream& operator<<(std::ostream& os, const Epoch& e) {
+        return os << e.clock << '@' << e.thread;
+    }
+};
+
+// Read shadow of a location. Stays a single epoch while reads are totally
+// ordered and is inflated to a full vector clock only once two reads are
+// concurrent (read-shared). The clock lives out of line so that epoch-mode
+// shadows stay small; a null `shared` means epoch mode.
+template <typename Clock>
+struct BasicReadShadow {
+    Epoch epoch;
+    std::unique_ptr<Clock> shared;
+
+    BasicReadShadow() = default;
+    BasicReadShadow(const BasicReadShadow& other)
+        : epoch(other.epoch), shared(other.shared ? std::make_unique<Clock>(*other.shared) : nullptr) {}
+    BasicReadShadow(BasicReadShadow&& other) noexcept = default;
+    BasicReadShadow& operator=(const BasicReadShadow& other) {
+        if (this != &other) {
+            epoch = other.epoch;
+            shared = other.shared ? std::make_unique<Clock>(*other.shared) : nullptr;
+        }
+        return *this;
+    }
+    BasicReadShadow& operator=(BasicReadShadow&& other) noexcept = default;
+
+    bool isShared() const { return shared != nullptr; }
+
+    // Switch to read-shared mode, keeping the current epoch and adding e.
+    void inflate(int num_threads, const Epoch& e) {
+        shared = std::make_unique<Clock>(num_threads);
+        (*shared)[epoch.thread] = epoch.clock;
+        (*shared)[e.thread] = e.clock;
+    }
+
+    // Drop back to epoch mode with the given epoch.
+    void collapse(const Epoch& e) {
+        shared.reset();
+        epoch = e;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const BasicReadShadow& r) {
+        if (r.isShared()) return os << *r.shared;
+        return os << r.epoch;
+    }
+};
+
+#endif
@@ -0,0 +1,16 @@
+#include "event.h"
+
+const char* opcodeName(Opcode op) {
+    switch (op) {
+    case Opcode::Read:        return "Read";
+    case Opcode::Write:       return "Write";
+    case Opcode::Acquire:     return "Acquire";
+    case Opcode::Release:     return "Release";
+    case Opcode::AtomicLoad:  return "AtomicLoad";
+    case Opcode::AtomicStore: return "AtomicStore";
+    case Opcode::AtomicRMW:   return "AtomicRMW";
+    case Opcode::Fork:        return "Fork";
+    case Opcode::Join:        return "Join";
+    }
+    return "Unknown";
+}
@@ -0,0 +1,37 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <cstdint>
+#include <string>
+
+enum class Opcode : std::uint8_t {
+    Read,
+    Write,
+    Acquire,
+    Release,
+    AtomicLoad,
+    AtomicStore,
+    AtomicRMW,
+    Fork,
+    Join,
+};
+
+// Compact, trivially copyable encoding of one trace event. `object` is the
+// interned ID of the location (Read/Write), the child thread (Fork/Join) or
+// the lock / atomic object (everything else) in the owning VectorClockState.
+struct Event {
+    Opcode op;
+    std::uint32_t thread;
+    std::uint64_t object;
+};
+
+static_assert(sizeof(Event) == 16, "Event must stay a packed 16-byte record");
+
+const char* opcodeName(Opcode op);
+
+// Read and Write touch the location tables, Fork and Join only thread
+// clocks, everything else the lock table
+inline bool isAccess(Opcode op) { return op == Opcode::Read || op == Opcode::Write; }
+inline bool isThreadOp(Opcode op) { return op == Opcode::Fork || op == Opcode::Join; }
+
+#endif
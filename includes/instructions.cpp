@@ -1,153 +1,133 @@
+#include "instructions.h"
+#include "shadowmemory.h"
 #include <string>
 #include <iostream>
 
 
-class Instruction {
-public:
-    virtual ~Instruction() {}
-    virtual int getThreadId() const = 0;
-    virtual std::string getLocation() const = 0;
-    virtual std::string toString() const = 0;
-    virtual void print(std::ostream& os) const = 0;
-};
-
-class Read : public Instruction {
-private:
-    int thread_id;
-    std::string location;
-
-public:
-    Read(int id, std::string loc) : thread_id(id), location(std::move(loc)) {}
-    int getThreadId() const { return thread_id; }
-    std::string getLocation() const override { return location; }
-
-    std::string toString() const override {
-        return "Read(" + std::to_string(thread_id) + ", " + location + ")";
-    }
-
-    void print(std::ostream& os) const override {
-        os << "Read(" << thread_id << ", " << location << ")";
-    }
-};
-
-class Write : public Instruction {
-private:
-    int thread_id;
-    std::string location;
-
-public:
-    Write(int id, std::string loc) : thread_id(id), location(std::move(loc)) {}
-    int getThreadId() const { return thread_id; }
-    std::string getLocation() const override { return location; }
-
-    std::string toString() const override {
-        return "Write(" + std::to_string(thread_id) + ", " + location + ")";
-    }
-
-    void print(std::ostream& os) const override {
-        os << "Write(" << thread_id << ", " << location << ")";
-    }
-};
-
-class Acquire : public Instruction{
-private:
-    int thread_id;
-    std::string lock;
-
-public:
-    Acquire(int id, std::string lockName) : thread_id(id), lock(std::move(lockName)) {}
-    int getThreadId() const { return thread_id; }
-    std::string getLock() const { return lock; }
-    std::string getLocation() const override { return lock; }
-
-    std::string toString() const override {
-        return "Acquire(" + std::to_string(thread_id) + ", " + lock + ")";
-    }
-
-    void print(std::ostream& os) const override {
-        os << "Acquire(" << thread_id << ", " << lock << ")";
-    }
-};
-
-class Release : public Instruction {
-private:
-    int thread_id;
-    std::string lock;
-
-public:
-    Release(int id, std::string lockName) : thread_id(id), lock(std::move(lockName)) {}
-    int getThreadId() const { return thread_id; }
-    std::string getLock() const { return lock; }
-    std::string getLocation() const override { return lock; }
-
-    std::string toString() const override {
-        return "Release(" + std::to_string(thread_id) + ", " + lock + ")";
-    }
-
-    void print(std::ostream& os) const override {
-        os << "Release(" << thread_id << ", " << lock << ")";
-    }
-};
-
-class AtomicLoad : public Instruction{
-private:
-    int thread_id;
-    std::string atomic_obj;
-
-public:
-    AtomicLoad(int id, std::string objName) : thread_id(id), atomic_obj(std::move(objName)) {}
-    int getThreadId() const { return thread_id; }
-    std::string getAtomicObj() const { return atomic_obj; }
-    std::string getLocation() const override { return atomic_obj; }
-
-    std::string toString() const override {
-        return "AtomicLoad(" + std::to_string(thread_id) + ", " + atomic_obj + ")";
-    }
-
-    void print(std::ostream& os) const override {
-        os << "AtomicLoad(" << thread_id << ", " << atomic_obj << ")";
-    }
-};
-
-class AtomicStore : public Instruction{
-private:
-    int thread_id;
-    std::string atomic_obj;
-
-public:
-    AtomicStore(int id, std::string objName) : thread_id(id), atomic_obj(std::move(objName)) {}
-    int getThreadId() const { return thread_id; }
-    std::string getAtomicObj() const { return atomic_obj; }
-    std::string getLocation() const override { return atomic_obj; }
-
-    std::string toString() const override {
-        return "AtomicStore(" + std::to_string(thread_id) + ", " + atomic_obj + ")";
-    }
-
-    void print(std::ostream& os) const override {
-        os << "AtomicStore(" << thread_id << ", " << atomic_obj << ")";
-    }
-};
-
-class AtomicRMW : public Instruction {
-private:
-    int thread_id;
-    std::string atomic_obj;
-
-public:
-    AtomicRMW(int id, std::string objName) : thread_id(id), atomic_obj(std::move(objName)) {}
-    int getThreadId() const { return thread_id; }
-    std::string getAtomicObj() const { return atomic_obj; }
-    std::string getLocation() const override { return atomic_obj; }
-
-    std::string toString() const override {
-        return "AtomicRMW(" + std::to_string(thread_id) + ", " + atomic_obj + ")";
-    }
-
-    void print(std::ostream& os) const override {
-        os << "AtomicRMW(" << thread_id << ", " << atomic_obj << ")";
-    }
-};
+Read::Read(int id, std::string loc) : thread_id(id), location(std::move(loc)) {}
+Read::Read(int id, std::uint64_t addr) : thread_id(id), location(addressName(addr)), address(addr), addressed(true) {}
+Opcode Read::getOpcode() const { return Opcode::Read; }
+int Read::getThreadId() const { return thread_id; }
+const std::string& Read::getLocation() const { return location; }
+bool Read::hasAddress() const { return addressed; }
+std::uint64_t Read::getAddress() const { return address; }
+
+std::string Read::toString() const {
+    return "Read(" + std::to_string(thread_id) + ", " + location + ")";
+}
+
+void Read::print(std::ostream& os) const {
+    os << "Read(" << thread_id << ", " << location << ")";
+}
+
+Write::Write(int id, std::string loc) : thread_id(id), location(std::move(loc)) {}
+Write::Write(int id, std::uint64_t addr) : thread_id(id), location(addressName(addr)), address(addr), addressed(true) {}
+Opcode Write::getOpcode() const { return Opcode::Write; }
+int Write::getThreadId() const { return thread_id; }
+const std::string& Write::getLocation() const { return location; }
+bool Write::hasAddress() const { return addressed; }
+std::uint64_t Write::getAddress() const { return address; }
+
+std::string Write::toString() const {
+    return "Write(" + std::to_string(thread_id) + ", " + location + ")";
+}
+
+void Write::print(std::ostream& os) const {
+    os << "Write(" << thread_id << ", " << location << ")";
+}
+
+Acquire::Acquire(int id, std::string loc) : thread_id(id), location(std::move(loc)) {}
+Opcode Acquire::getOpcode() const { return Opcode::Acquire; }
+int Acquire::getThreadId() const { return thread_id; }
+const std::string& Acquire::getLocation() const { return location; }
+
+std::string Acquire::toString() const {
+    return "Acquire(" + std::to_string(thread_id) + ", " + location + ")";
+}
+
+void Acquire::print(std::ostream& os) const {
+    os << "Acquire(" << thread_id << ", " << location << ")";
+}
+
+Release::Release(int id, std::string loc) : thread_id(id), location(std::move(loc)) {}
+Opcode Release::getOpcode() const { return Opcode::Release; }
+int Release::getThreadId() const { return thread_id; }
+const std::string& Release::getLocation() const { return location; }
+
+std::string Release::toString() const {
+    return "Release(" + std::to_string(thread_id) + ", " + location + ")";
+}
+
+void Release::print(std::ostream& os) const {
+    os << "Release(" << thread_id << ", " << location << ")";
+}
+
+AtomicLoad::AtomicLoad(int id, std::string objName) : thread_id(id), atomic_obj(std::move(objName)) {}
+Opcode AtomicLoad::getOpcode() const { return Opcode::AtomicLoad; }
+int AtomicLoad::getThreadId() const { return thread_id; }
+const std::string& AtomicLoad::getLocation() const { return atomic_obj; }
+
+std::string AtomicLoad::toString() const {
+    return "AtomicLoad(" + std::to_string(thread_id) + ", " + atomic_obj + ")";
+}
+
+void AtomicLoad::print(std::ostream& os) const {
+    os << "AtomicLoad(" << thread_id << ", " << atomic_obj << ")";
+}
+
+AtomicStore::AtomicStore(int id, std::string objName) : thread_id(id), atomic_obj(std::move(objName)) {}
+Opcode AtomicStore::getOpcode() const { return Opcode::AtomicStore; }
+int AtomicStore::getThreadId() const { return thread_id; }
+const std::string& AtomicStore::getLocation() const { return atomic_obj; }
+
+std::string AtomicStore::toString() const {
+    return "AtomicStore(" + std::to_string(thread_id) + ", " + atomic_obj + ")";
+}
+
+void AtomicStore::print(std::ostream& os) const {
+    os << "AtomicStore(" << thread_id << ", " << atomic_obj << ")";
+}
+
+AtomicRMW::AtomicRMW(int id, std::string objName) : thread_id(id), atomic_obj(std::move(objName)) {}
+Opcode AtomicRMW::getOpcode() const { return Opcode::AtomicRMW; }
+int AtomicRMW::getThreadId() const { return thread_id; }
+const std::string& AtomicRMW::getLocation() const { return atomic_obj; }
+
+std::string AtomicRMW::toString() const {
+    return "AtomicRMW(" + std::to_string(thread_id) + ", " + atomic_obj + ")";
+}
+
+void AtomicRMW::print(std::ostream& os) const {
+    os << "AtomicRMW(" << thread_id << ", " << atomic_obj << ")";
+}
+
+Fork::Fork(int id, int childId) : thread_id(id), child_id(childId), child(std::to_string(childId)) {}
+Opcode Fork::getOpcode() const { return Opcode::Fork; }
+int Fork::getThreadId() const { return thread_id; }
+int Fork::getChildId() const { return child_id; }
+const std::string& Fork::getLocation() const { return child; }
+
+std::string Fork::toString() const {
+    return "Fork(" + std::to_string(thread_id) + ", " + child + ")";
+}
+
+void Fork::print(std::ostream& os) const {
+    os << "Fork(" << thread_id << ", " << child_id << ")";
+}
+
+Join::Join(int id, int childId) : thread_id(id), child_id(childId), child(std::to_string(childId)) {}
+Opcode Join::getOpcode() const { return Opcode::Join; }
+int Join::getThreadId() const { return thread_id; }
+int Join::getChildId() const { return child_id; }
+const std::string& Join::getLocation() const { return child; }
+
+std::string Join::toString() const {
+    return "Join(" + std::to_string(thread_id) + ", " + child + ")";
+}
+
+void Join::print(std::ostream& os) const {
+    os << "Join(" << thread_id << ", " << child_id << ")";
+}
 
 std::ostream& operator<<(std::ostream& os, const Instruction& instr) {
     instr.print(os);
@@ -155,4 +135,4 @@ std::ostream& operator<<(std::ostream& os, const Instruction& instr) {
 }
 
 
-// End of Instructions
\ No newline at end of file
+// End of Instructions
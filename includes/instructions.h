@@ -1,11 +1,17 @@
+#ifndef INSTRUCTIONS_H
+#define INSTRUCTIONS_H
+
+#include "event.h"
+#include <cstdint>
 #include <iostream>
 #include <string>
 
 class Instruction {
 public:
     virtual ~Instruction() {}  // Virtual destructor to ensure proper cleanup
+    virtual Opcode getOpcode() const = 0;
     virtual int getThreadId() const = 0;
-    virtual std::string getLocation() const = 0;
+    virtual const std::string& getLocation() const = 0;
     virtual std::string toString() const = 0;  // For verbose output
     virtual void print(std::ostream& os) const = 0;
 };
@@ -15,11 +21,18 @@ class Read : public Instruction {
 private:
     int thread_id;
     std::string location;
+    std::uint64_t address = 0;
+    bool addressed = false;
 
 public:
     Read(int id, std::string loc);
+    // Access to a memory address instead of a named location
+    Read(int id, std::uint64_t addr);
+    Opcode getOpcode() const override;
     int getThreadId() const override;
-    std::string getLocation() const override;
+    const std::string& getLocation() const override;
+    bool hasAddress() const;
+    std::uint64_t getAddress() const;
     std::string toString() const override;
     void print(std::ostream& os) const override;
 };
@@ -27,10 +40,17 @@ public:
 class Write : public Instruction {
     int thread_id;
     std::string location;
+    std::uint64_t address = 0;
+    bool addressed = false;
 public:
     Write(int id, std::string loc);
+    // Access to a memory address instead of a named location
+    Write(int id, std::uint64_t addr);
+    Opcode getOpcode() const override;
     int getThreadId() const override;
-    std::string getLocation() const override;
+    const std::string& getLocation() const override;
+    bool hasAddress() const;
+    std::uint64_t getAddress() const;
     std::string toString() const override;
     void print(std::ostream& os) const override;
 };
@@ -41,8 +61,9 @@ class Acquire : public Instruction {
     std::string location;
 public:
     Acquire(int id, std::string loc);
+    Opcode getOpcode() const override;
     int getThreadId() const override;
-    std::string getLocation() const override;
+    const std::string& getLocation() const override;
     std::string toString() const override;
     void print(std::ostream& os) const override;
 };
@@ -53,8 +74,9 @@ class Release : public Instruction {
     std::string location;
 public:
     Release(int id, std::string loc);
+    Opcode getOpcode() const override;
     int getThreadId() const override;
-    std::string getLocation() const override;
+    const std::string& getLocation() const override;
     std::string toString() const override;
     void print(std::ostream& os) const override;
 };
@@ -65,8 +87,9 @@ private:
     std::string atomic_obj;
 public:
     AtomicLoad(int id, std::string objName);
+    Opcode getOpcode() const override;
     int getThreadId() const override;
-    std::string getLocation() const override;
+    const std::string& getLocation() const override;
     std::string toString() const override;
     void print(std::ostream& os) const override;
 };
@@ -77,8 +100,9 @@ private:
     std::string atomic_obj;
 public:
     AtomicStore(int id, std::string objName);
+    Opcode getOpcode() const override;
     int getThreadId() const override;
-    std::string getLocation() const override;
+    const std::string& getLocation() const override;
     std::string toString() const override;
     void print(std::ostream& os) const override;
 };
@@ -89,10 +113,43 @@ private:
     std::string atomic_obj;
 public:
     AtomicRMW(int id, std::string objName);
+    Opcode getOpcode() const override;
+    int getThreadId() const override;
+    const std::string& getLocation() const override;
+    std::string toString() const override;
+    void print(std::ostream& os) const override;
+};
+
+// Thread id starts thread childId; getLocation() is the child ID as text
+class Fork : public Instruction {
+    int thread_id;
+    int child_id;
+    std::string child;
+public:
+    Fork(int id, int childId);
+    Opcode getOpcode() const override;
     int getThreadId() const override;
-    std::string getLocation() const override;
+    int getChildId() const;
+    const std::string& getLocation() const override;
     std::string toString() const override;
     void print(std::ostream& os) const override;
 };
 
-std::ostream& operator<<(std::ostream& os, const Instruction& instr);
\ No newline at end of file
+// Thread id waits for thread childId to finish
+class Join : public Instruction {
+    int thread_id;
+    int child_id;
+    std::string child;
+public:
+    Join(int id, int childId);
+    Opcode getOpcode() const override;
+    int getThreadId() const override;
+    int getChildId() const;
+    const std::string& getLocation() const override;
+    std::string toString() const override;
+    void print(std::ostream& os) const override;
+};
+
+std::ostream& operator<<(std::ostream& os, const Instruction& instr);
+
+#endif
@@ -0,0 +1,203 @@
+#include "online.h"
+#include "shadowmemory.h"
+#include "stats.h"
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Shadow of one location presented through the state interface that
+// detectRead/detectWrite use; the location ID is ignored
+struct AccessView {
+    BasicReadShadow<VectorClock>& read;
+    Epoch& write;
+    const VectorClock& clock;
+    const SymbolTable& names;
+
+    BasicReadShadow<VectorClock>& getR(int) { return read; }
+    Epoch& getW(int) { return write; }
+    void updateW(int, const Epoch& e) { write = e; }
+    const VectorClock& getC(int) const { return clock; }
+    Epoch epoch(int t) const { return Epoch(t, clock[t]); }
+    int threadOf(const Epoch& e) const { return e.thread; }
+    VectorClock& sharedRead(const BasicReadShadow<VectorClock>& r) { return *r.shared; }
+    void inflate(BasicReadShadow<VectorClock>& r, const Epoch& e) { r.inflate(clock.size(), e); }
+    void collapse(BasicReadShadow<VectorClock>& r, const Epoch& e) { r.collapse(e); }
+    const SymbolTable& locations() const { return names; }
+    const SymbolTable& locks() const { return names; }
+};
+
+std::size_t stripeOf(std::uint64_t key, std::size_t stripes) {
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (stripes - 1);
+}
+
+}
+
+OnlineDetector::OnlineDetector(int maxThreads, const RunOptions& options, int granularity, bool cacheAccesses)
+    : options(options), cacheAccesses(cacheAccesses), threads(maxThreads > 0 ? maxThreads : 0),
+      locationStripes(std::make_unique<LocationStripe[]>(LOCATION_STRIPES)),
+      lockStripes(std::make_unique<LockStripe[]>(LOCK_STRIPES)) {
+    switch (granularity) {
+    case 1: shift = 0; break;
+    case 4: shift = 2; break;
+    case 8: shift = 3; break;
+    default:
+        throw std::invalid_argument("Unsupported address granularity " + std::to_string(granularity));
+    }
+    for (int t = 0; t < numThreads(); ++t) {
+        threads[t].clock = VectorClock(numThreads());
+        threads[t].clock.increment(t);
+    }
+}
+
+VectorClock& OnlineDetector::clockOf(int t) {
+    if (t < 0 || t >= numThreads()) {
+        throw std::out_of_range("Unknown thread " + std::to_string(t));
+    }
+    return threads[t].clock;
+}
+
+VectorClock& OnlineDetector::lockClock(std::uint64_t lock) {
+    LockStripe& stripe = lockStripes[stripeOf(lock, LOCK_STRIPES)];
+    std::lock_guard<std::mutex> guard(stripe.lock);
+    auto it = stripe.clocks.find(lock);
+    if (it == stripe.clocks.end()) {
+        // A lock nobody has released yet has the zero clock
+        it = stripe.clocks.emplace(lock, VectorClock(numThreads())).first;
+    }
+    return it->second;
+}
+
+void OnlineDetector::onRead(int t, std::uint64_t address) {
+    access(Opcode::Read, t, address);
+}
+
+void OnlineDetector::onWrite(int t, std::uint64_t address) {
+    access(Opcode::Write, t, address);
+}
+
+void OnlineDetector::onAcquire(int t, std::uint64_t lock) {
+    VectorClock& c = clockOf(t);
+    if (stopped()) {
+        return;
+    }
+    StatEvent stat(Opcode::Acquire);
+    lockClock(lock).joinInto(c);
+}
+
+void OnlineDetector::onRelease(int t, std::uint64_t lock) {
+    VectorClock& c = clockOf(t);
+    if (stopped()) {
+        return;
+    }
+    StatEvent stat(Opcode::Release);
+    lockClock(lock).assignFrom(c);
+    c.increment(t);
+}
+
+void OnlineDetector::onFork(int t, int child) {
+    VectorClock& c = clockOf(t);
+    VectorClock& d = clockOf(child);
+    if (stopped()) {
+        return;
+    }
+    StatEvent stat(Opcode::Fork);
+    c.joinInto(d);
+    c.increment(t);
+}
+
+void OnlineDetector::onJoin(int t, int child) {
+    VectorClock& c = clockOf(t);
+    VectorClock& d = clockOf(child);
+    if (stopped()) {
+        return;
+    }
+    StatEvent stat(Opcode::Join);
+    d.joinInto(c);
+    d.increment(child);
+}
+
+void OnlineDetector::access(Opcode op, int t, std::uint64_t address) {
+    const VectorClock& c = clockOf(t);
+    if (stopped()) {
+        return;
+    }
+    const std::uint64_t granule = address >> shift << shift;
+    const int clock = c[t];
+    const std::uint8_t kind = op == Opcode::Read ? CACHED_READ : CACHED_WRITE;
+    // A race bumped concurrently and not seen yet is ordered after this
+    // access, which is as good as any order for two unordered events
+    const std::uint32_t generation = raceGeneration.load(std::memory_order_relaxed);
+
+    StatEvent stat(op);
+    CachedAccess* cached = cacheAccesses ? &threads[t].accesses[(granule >> shift) & (ACCESS_CACHE_SLOTS - 1)] : nullptr;
+    const bool sameEpoch = cached && cached->granule == granule && cached->clock == clock && cached->generation == generation;
+    if (sameEpoch && (cached->kinds & kind)) {
+        return;
+    }
+
+    LocationStripe& stripe = locationStripes[stripeOf(granule >> shift, LOCATION_STRIPES)];
+
+    // Caps and stopping are applied in record(), so the check itself
+    // always collects and always updates the shadow
+    RunOptions check;
+    check.collectAll = true;
+    RunResult result;
+    const Event ev{op, static_cast<std::uint32_t>(t), 0};
+
+    std::lock_guard<std::mutex> guard(stripe.lock);
+    auto [it, inserted] = stripe.shadows.try_emplace(granule);
+    if (inserted) {
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+    }
+    LocationShadow& shadow = it->second;
+    AccessView view{shadow.read, shadow.write, c, racyLocations};
+    if (op == Opcode::Read) {
+        detectRead(view, ev, check, result);
+    } else {
+        detectWrite(view, ev, check, result);
+    }
+    if (!result.races.empty()) {
+        record(result.races, shadow, granule);
+    }
+
+    // A write may have reset a read-shared read shadow, so it drops the
+    // read. After a race the generation has moved on and this entry is
+    // already stale, which is harmless.
+    if (cached) {
+        const std::uint8_t kinds = kind == CACHED_WRITE ? kind : static_cast<std::uint8_t>((sameEpoch ? cached->kinds : 0) | kind);
+        *cached = CachedAccess{granule, clock, generation, kinds};
+    }
+}
+
+void OnlineDetector::record(std::vector<Race>& races, LocationShadow& shadow, std::uint64_t granule) {
+    // The racy access rewrote the shadow: no cached same-epoch access holds
+    raceGeneration.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> guard(raceLock);
+    for (Race& race : races) {
+        if (stopped()) {
+            return;
+        }
+        if (options.maxRacesPerLocation > 0) {
+            if (shadow.races >= options.maxRacesPerLocation) {
+                return;
+            }
+            ++shadow.races;
+        }
+        race.location = racyLocations.intern(addressName(granule));
+        found.push_back(race);
+        if (!options.collectAll || (options.maxRaces > 0 && found.size() >= options.maxRaces)) {
+            halted.store(true, std::memory_order_release);
+        }
+    }
+}
+
+std::vector<Race> OnlineDetector::races() const {
+    std::lock_guard<std::mutex> guard(raceLock);
+    return found;
+}
+
+SymbolTable OnlineDetector::raceLocations() const {
+    std::lock_guard<std::mutex> guard(raceLock);
+    return racyLocations;
+}
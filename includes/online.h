@@ -0,0 +1,126 @@
+#ifndef ONLINE_H
+#define ONLINE_H
+
+#include "detect.h"
+#include "epoch.h"
+#include "race.h"
+#include "symboltable.h"
+#include "vectorclock.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Detector for a live instrumented program. The on* hooks are called from
+// the program's own threads, concurrently, as the events happen; thread t
+// must only ever be passed by the thread it names. Locations and locks are
+// identified by address.
+//
+// Nothing is serialized globally:
+//  - each thread's clock is only written by that thread (and by its parent
+//    around onFork/onJoin, which the thread start and join already order);
+//  - a location's shadow is checked and updated under one of
+//    LOCATION_STRIPES locks, chosen by the address;
+//  - a lock's clock is found under one of LOCK_STRIPES table locks and then
+//    used under the program's own lock, so onAcquire must be called after
+//    the lock is taken and onRelease before it is given up.
+//
+// Tight loops repeat the same access within one epoch, and FastTrack has
+// nothing to do for the repeats. Each thread therefore keeps a small
+// direct-mapped cache of the granules it has checked in its current epoch,
+// so a repeat returns without taking the stripe lock or probing the shadow
+// table. Entries carry the thread's clock value and go stale on its next
+// release or fork. A race found by any thread also invalidates every
+// cache, since it is the only way another thread can rewrite a shadow that
+// this thread has already checked in its epoch. Pass cacheAccesses = false
+// to check every access, e.g. to rule the cache out when chasing a report.
+//
+// The thread count is fixed up front so that clocks never move; thread IDs
+// past maxThreads - 1 throw std::out_of_range. RunOptions caps apply as in
+// a run; once the run would stop (the first race, unless collectAll), later
+// events are ignored. Verbose output, logs, deduplication, suppressions and
+// sampling are not supported.
+class OnlineDetector {
+public:
+    static constexpr std::size_t LOCATION_STRIPES = 4096;
+    static constexpr std::size_t LOCK_STRIPES = 256;
+    static constexpr std::size_t ACCESS_CACHE_SLOTS = 64;
+
+    // Throws std::invalid_argument unless granularity is 1, 4 or 8
+    explicit OnlineDetector(int maxThreads, const RunOptions& options = RunOptions(), int granularity = 8,
+                            bool cacheAccesses = true);
+
+    OnlineDetector(const OnlineDetector&) = delete;
+    OnlineDetector& operator=(const OnlineDetector&) = delete;
+
+    void onRead(int t, std::uint64_t address);
+    void onWrite(int t, std::uint64_t address);
+    void onAcquire(int t, std::uint64_t lock);
+    void onRelease(int t, std::uint64_t lock);
+    // Call before child starts / after child has finished
+    void onFork(int t, int child);
+    void onJoin(int t, int child);
+
+    int numThreads() const { return static_cast<int>(threads.size()); }
+    bool stopped() const { return halted.load(std::memory_order_acquire); }
+
+    // Races found so far. Their location IDs index raceLocations(), which
+    // names the granule of each racy location ("0x...").
+    std::vector<Race> races() const;
+    SymbolTable raceLocations() const;
+
+private:
+    // A granule this thread has checked in its current epoch
+    struct CachedAccess {
+        std::uint64_t granule = 0;
+        int clock = 0;                  // own clock entry then; never 0 once running
+        std::uint32_t generation = 0;   // raceGeneration then
+        std::uint8_t kinds = 0;         // CACHED_READ and/or CACHED_WRITE
+    };
+    static constexpr std::uint8_t CACHED_READ = 1;
+    static constexpr std::uint8_t CACHED_WRITE = 2;
+
+    struct alignas(64) ThreadShadow {
+        VectorClock clock;
+        CachedAccess accesses[ACCESS_CACHE_SLOTS];
+    };
+
+    struct LocationShadow {
+        BasicReadShadow<VectorClock> read;
+        Epoch write;
+        std::size_t races = 0;   // for RunOptions::maxRacesPerLocation
+    };
+
+    struct alignas(64) LocationStripe {
+        std::mutex lock;
+        std::unordered_map<std::uint64_t, LocationShadow> shadows;
+    };
+
+    struct alignas(64) LockStripe {
+        std::mutex lock;
+        std::unordered_map<std::uint64_t, VectorClock> clocks;
+    };
+
+    RunOptions options;
+    int shift;
+    bool cacheAccesses;
+    std::vector<ThreadShadow> threads;
+    std::unique_ptr<LocationStripe[]> locationStripes;
+    std::unique_ptr<LockStripe[]> lockStripes;
+
+    std::atomic<bool> halted{false};
+    std::atomic<std::uint32_t> raceGeneration{0};
+    mutable std::mutex raceLock;
+    std::vector<Race> found;
+    SymbolTable racyLocations;
+
+    VectorClock& clockOf(int t);
+    VectorClock& lockClock(std::uint64_t lock);
+    void access(Opcode op, int t, std::uint64_t address);
+    void record(std::vector<Race>& races, LocationShadow& shadow, std::uint64_t granule);
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "parallel.h"
+#include "parallelhandle.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+ParallelContext& ParallelHandle::get() {
+    if (!context) {
+        context = std::make_shared<ParallelContext>();
+    }
+    return *context;
+}
+
+ParallelContext::~ParallelContext() {
+    stop();
+}
+
+void ParallelContext::prepare(int workers) {
+    if (static_cast<int>(shards.size()) == workers) {
+        return;
+    }
+    // Location ownership depends on the count, so start over
+    stop();
+    shards.clear();
+    shards.reserve(workers);
+    for (int i = 0; i < workers; ++i) {
+        shards.emplace_back(i, workers);
+    }
+    quit = false;
+    for (int i = 1; i < workers; ++i) {
+        // A new worker waits for the next round, not one already run
+        threads.emplace_back([this, i, start = round] { work(i, start); });
+    }
+}
+
+void ParallelContext::runAll(const std::function<void(int)>& job) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        this->job = &job;
+        pending = static_cast<int>(threads.size());
+        ++round;
+    }
+    wake.notify_all();
+    job(0);
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this] { return pending == 0; });
+    this->job = nullptr;
+}
+
+void ParallelContext::work(int i, std::uint64_t seen) {
+    for (;;) {
+        const std::function<void(int)>* next;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return quit || round != seen; });
+            if (quit) {
+                return;
+            }
+            seen = round;
+            next = job;
+        }
+        (*next)(i);
+        std::lock_guard<std::mutex> guard(lock);
+        if (--pending == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ParallelContext::stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
@@ -0,0 +1,442 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "detect.h"
+#include "event.h"
+#include "epoch.h"
+#include "parallelhandle.h"
+#include "race.h"
+#include "symboltable.h"
+#include "vectorclock.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Location-sharded parallel version of detectEvents.
+//
+// Checks on different locations are independent once the thread clocks are
+// known, and a thread's clock only changes at its own synchronization
+// events. The trace is therefore analysed in windows: the calling thread
+// applies the sync events of a window to C and L in trace order and tags
+// each Read/Write with a snapshot of its thread's clock, taken only when the
+// clock has changed since the thread's last access. The accesses are then
+// split by location across the workers. Each worker owns the R and W shadows
+// of its locations (location ID modulo the worker count) and checks them in
+// trace order, and the races are merged by trace position.
+//
+// The state stays the owner of the shadows. A worker copies a location's
+// shadow the first time a call touches it and writes it back at the end of
+// the call, so a call costs time in the locations it touches, not in all of
+// them. The shards, snapshot buffers and worker
+// threads are kept in the state's ParallelContext from call to call, so a
+// trace fed in small batches (e.g. by runTextTrace) does not rebuild them.
+//
+// Races and RunResult fields are the same as those of detectEvents. The
+// one difference is a stopping run: C, L, the shadows, the per-location
+// and dedupe bookkeeping and the sampler are left as of the end of the
+// window the racy event fell in, not just before that event.
+// Verbose and logged runs fall back to detectEvents.
+
+// Most events per window; a window also ends early once its clock snapshots
+// reach PARALLEL_SNAPSHOT_ENTRIES entries in total
+constexpr std::size_t PARALLEL_WINDOW_SIZE = std::size_t(1) << 18;
+constexpr std::size_t PARALLEL_SNAPSHOT_ENTRIES = std::size_t(1) << 24;
+
+// Shadow state of one worker, presenting the parts of the state interface
+// that detectRead/detectWrite use. getC(t) is the snapshot tagged on the
+// access being checked.
+class ShardState {
+public:
+    struct Task {
+        std::size_t position;   // index of the event in the run
+        Event ev;
+        int snapshot;
+        int slot;               // clock slot of ev.thread
+    };
+    // The shared state's threadOf, read-only while the shards run
+    using Owner = std::function<int(const Epoch&)>;
+
+    std::vector<Task> tasks;
+    RunResult result;
+    std::vector<std::size_t> racePositions;   // trace position of each race in result
+    std::exception_ptr error;
+
+    ShardState(int index, int count) : index(index), count(count) {}
+
+    bool owns(int id) const { return id % count == index; }
+    int slot(int id) const { return id / count; }
+
+    // Start a call on state's tables that appends to outer. Race counts are
+    // loaded with the shadows when countRaces is set, and dedupe keys are
+    // looked up in outer.seen, which stays unchanged until the call ends.
+    void begin(const SymbolTable& locks, const SymbolTable& locations, Owner threadOf,
+               const RunResult& outer, bool countRaces) {
+        lockNames = &locks;
+        locationNames = &locations;
+        owner = std::move(threadOf);
+        this->outer = &outer;
+        this->countRaces = countRaces;
+        result.races.clear();
+        result.stopped = false;
+        result.seen = RaceSet();
+        result.seen.layerOver(&outer.seen);
+        racePositions.clear();
+        error = nullptr;
+        touched.clear();
+        // Stamp 0 means never loaded, so skip it when the counter wraps
+        if (++call == 0) {
+            std::fill(loadedIn.begin(), loadedIn.end(), 0);
+            call = 1;
+        }
+    }
+
+    // Write back the shadows this call loaded, in place. Run by the worker
+    // once the call's windows are done. Locations the calling thread must
+    // store() itself are left in deferred: those whose read shadow changes
+    // mode, which may allocate in the state, and those with new races.
+    template <typename State>
+    void storeLoaded(State& state) {
+        deferred.clear();
+        for (int id : touched) {
+            const BasicReadShadow<VectorClock>& local = R[slot(id)];
+            auto& r = state.getR(id);
+            if (local.isShared() != r.isShared() || (countRaces && result.racesPerLocation[id] != outerCount(id))) {
+                deferred.push_back(id);
+                continue;
+            }
+            state.updateW(id, W[slot(id)]);
+            if (!local.isShared()) {
+                r.epoch = local.epoch;
+                continue;
+            }
+            auto&& clock = state.sharedRead(r);
+            const int width = std::min(state.clockWidth(), local.shared->size());
+            for (int u = 0; u < width; ++u) {
+                clock[u] = (*local.shared)[u];
+            }
+        }
+    }
+
+    // Locations storeLoaded left for store()
+    const std::vector<int>& unstored() const { return deferred; }
+
+    // Write the shadow and race count of location id back after the call
+    template <typename State>
+    void store(State& state, RunResult& outer, int id) const {
+        if (countRaces) {
+            const std::size_t count = result.racesPerLocation[id];
+            if (id < static_cast<int>(outer.racesPerLocation.size())) {
+                outer.racesPerLocation[id] = count;
+            } else if (count > 0) {
+                outer.racesPerLocation.resize(id + 1, 0);
+                outer.racesPerLocation[id] = count;
+            }
+        }
+        state.updateW(id, W[slot(id)]);
+        auto& r = state.getR(id);
+        const BasicReadShadow<VectorClock>& local = R[slot(id)];
+        if (!local.isShared()) {
+            if (r.isShared()) {
+                state.collapse(r, local.epoch);
+            } else {
+                r.epoch = local.epoch;
+            }
+            return;
+        }
+        if (!r.isShared()) {
+            state.inflate(r, local.epoch);
+        }
+        auto&& clock = state.sharedRead(r);
+        const int width = std::min(state.clockWidth(), local.shared->size());
+        for (int u = 0; u < width; ++u) {
+            clock[u] = (*local.shared)[u];
+        }
+    }
+
+    // Check this window's tasks against the given clock snapshots. The
+    // shadows of state are only read, and only for this shard's locations.
+    template <typename State>
+    void run(State& state, const std::vector<VectorClock>& snapshots, const RunOptions& options) {
+        try {
+            for (const Task& task : tasks) {
+                current = &snapshots[task.snapshot];
+                currentSlot = task.slot;
+                const int id = static_cast<int>(task.ev.object);
+                grow(slot(id));
+                if (loadedIn[slot(id)] != call) {
+                    load(state, id);
+                }
+                Step step;
+                {
+                    StatEvent stat(task.ev.op);
+                    step = task.ev.op == Opcode::Read ? detectRead(*this, task.ev, options, result)
+                                                      : detectWrite(*this, task.ev, options, result);
+                }
+                racePositions.resize(result.races.size(), task.position);
+                if (step == Step::Stop) {
+                    break;
+                }
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    // State interface used by detectRead/detectWrite
+    BasicReadShadow<VectorClock>& getR(int id) { return R[slot(id)]; }
+    Epoch& getW(int id) { return W[slot(id)]; }
+    void updateW(int id, const Epoch& epoch) { W[slot(id)] = epoch; }
+    const VectorClock& getC(int) const { return *current; }
+    Epoch epoch(int) const { return Epoch(currentSlot, (*current)[currentSlot]); }
+    int threadOf(const Epoch& e) const { return owner(e); }
+    VectorClock& sharedRead(const BasicReadShadow<VectorClock>& r) {
+        // Slots may have been added since the clock was inflated
+        r.shared->resize(current->size());
+        return *r.shared;
+    }
+    void inflate(BasicReadShadow<VectorClock>& r, const Epoch& e) { r.inflate(current->size(), e); }
+    void collapse(BasicReadShadow<VectorClock>& r, const Epoch& e) { r.collapse(e); }
+    const SymbolTable& locks() const { return *lockNames; }
+    const SymbolTable& locations() const { return *locationNames; }
+
+private:
+    int index, count;
+    const SymbolTable* lockNames = nullptr;
+    const SymbolTable* locationNames = nullptr;
+    Owner owner;
+    std::vector<BasicReadShadow<VectorClock>> R;
+    std::vector<Epoch> W;
+    std::vector<std::uint32_t> loadedIn;   // per slot: the call that loaded it
+    std::vector<int> touched;
+    std::vector<int> deferred;
+    std::uint32_t call = 0;
+    const RunResult* outer = nullptr;
+    bool countRaces = false;
+    const VectorClock* current = nullptr;
+    int currentSlot = 0;
+
+    std::size_t outerCount(int id) const {
+        const auto& counts = outer->racesPerLocation;
+        return id < static_cast<int>(counts.size()) ? counts[id] : 0;
+    }
+
+    void grow(int s) {
+        if (s >= static_cast<int>(W.size())) {
+            R.resize(s + 1);
+            W.resize(s + 1);
+            loadedIn.resize(s + 1, 0);
+        }
+    }
+
+    // Copy the shadow of location id out of state. Slots added since the
+    // current snapshot have no reads yet, so its width is enough.
+    template <typename State>
+    void load(State& state, int id) {
+        loadedIn[slot(id)] = call;
+        touched.push_back(id);
+        if (countRaces) {
+            // Indexed by location ID, as report() does
+            if (id >= static_cast<int>(result.racesPerLocation.size())) {
+                result.racesPerLocation.resize(id + 1, 0);
+            }
+            result.racesPerLocation[id] = outerCount(id);
+        }
+        W[slot(id)] = state.getW(id);
+        auto& r = state.getR(id);
+        BasicReadShadow<VectorClock>& local = R[slot(id)];
+        local.epoch = r.epoch;
+        if (!r.isShared()) {
+            local.shared.reset();
+            return;
+        }
+        // Reuse the clock left from an earlier call, clearing what the
+        // state's clock does not cover
+        if (local.isShared()) {
+            local.shared->resize(current->size());
+        } else {
+            local.shared = std::make_unique<VectorClock>(current->size());
+        }
+        VectorClock& copy = *local.shared;
+        const int width = std::min(state.clockWidth(), current->size());
+        auto&& clock = state.sharedRead(r);
+        for (int u = 0; u < width; ++u) {
+            copy[u] = clock[u];
+        }
+        for (int u = width; u < copy.size(); ++u) {
+            copy[u] = 0;
+        }
+    }
+};
+
+// Shards, snapshot buffers and worker threads of detectParallel, kept
+// between calls (see parallelhandle.h). Owns no shadow state.
+class ParallelContext {
+public:
+    std::vector<ShardState> shards;
+    std::vector<VectorClock> snapshots;
+    std::vector<int> snapshotOf;    // per thread: its current snapshot, or -1
+
+    ParallelContext() = default;
+    ~ParallelContext();
+    ParallelContext(const ParallelContext&) = delete;
+    ParallelContext& operator=(const ParallelContext&) = delete;
+
+    // Shards for this many workers, rebuilt if the count changed
+    void prepare(int workers);
+    // Call job(i) for every shard i, job(0) on the calling thread and the
+    // others on the pooled workers; returns once all have finished
+    void runAll(const std::function<void(int)>& job);
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable wake, done;
+    const std::function<void(int)>* job = nullptr;
+    std::uint64_t round = 0;
+    int pending = 0;
+    bool quit = false;
+
+    void work(int i, std::uint64_t seen);
+    void stop();
+};
+
+// Analyse [begin, end) in place with options.workers threads, appending to
+// result. Same contract as detectEvents apart from the stopping state noted
+// above.
+template <typename State>
+void detectParallel(State& state, const Event* begin, const Event* end, const RunOptions& options, RunResult& result) {
+    const int workers = static_cast<int>(options.workers);
+    if (workers <= 1 || options.verbose || options.log) {
+        detectEvents(state, begin, end, options, result);
+        return;
+    }
+
+    if (options.suppress) {
+        options.suppress->update(state.locations());
+    }
+    ParallelContext& context = state.parallelContext();
+    context.prepare(workers);
+    std::vector<ShardState>& shards = context.shards;
+    for (auto& shard : shards) {
+        shard.begin(state.locks(), state.locations(), [&state](const Epoch& e) { return state.threadOf(e); },
+                    result, options.maxRacesPerLocation > 0);
+    }
+    std::vector<VectorClock>& snapshots = context.snapshots;
+    std::vector<int>& snapshotOf = context.snapshotOf;
+    RunOptions shardOptions = options;
+
+    const Event* it = begin;
+    while (it != end && !result.stopped) {
+        // Apply this window's sync events and tag its accesses
+        for (auto& shard : shards) {
+            shard.tasks.clear();
+        }
+        std::size_t used = 0, entries = 0;
+        std::fill(snapshotOf.begin(), snapshotOf.end(), -1);
+        const std::size_t windowStart = result.position;
+        std::size_t offset = 0;
+        for (; it != end && offset < PARALLEL_WINDOW_SIZE && entries < PARALLEL_SNAPSHOT_ENTRIES; ++it, ++offset) {
+            const Event& ev = *it;
+            const int t = static_cast<int>(ev.thread);
+            if (t >= static_cast<int>(snapshotOf.size())) {
+                snapshotOf.resize(t + 1, -1);
+            }
+            // Sampling decisions are made here, in trace order, so that they
+            // match a sequential run
+            if (isAccess(ev.op) && !sampled(options, ev)) {
+                continue;
+            }
+            const int oldWidth = state.clockWidth();
+            int slot = 0;
+            if (isAccess(ev.op)) {
+                // A thread's first access may give it a slot
+                slot = state.epoch(t).thread;
+            } else {
+                StatEvent stat(ev.op);
+                applySync(state, ev);
+            }
+            if (state.clockWidth() != oldWidth) {
+                // A new slot: every later snapshot must be as wide as the
+                // read-shared clocks it is compared with
+                std::fill(snapshotOf.begin(), snapshotOf.end(), -1);
+            }
+            if (isAccess(ev.op)) {
+                if (snapshotOf[t] < 0) {
+                    const int width = state.clockWidth();
+                    if (used == snapshots.size()) {
+                        snapshots.emplace_back(width);
+                    } else if (snapshots[used].size() != width) {
+                        snapshots[used] = VectorClock(width);
+                    }
+                    auto&& clock = state.getC(t);
+                    for (int u = 0; u < width; ++u) {
+                        snapshots[used][u] = clock[u];
+                    }
+                    snapshotOf[t] = static_cast<int>(used++);
+                    entries += width;
+                }
+                const int id = static_cast<int>(ev.object);
+                shards[id % workers].tasks.push_back(ShardState::Task{windowStart + offset, ev, snapshotOf[t], slot});
+            } else {
+                // Both threads' clocks and slots may have changed
+                snapshotOf[t] = -1;
+                if (isThreadOp(ev.op) && ev.object < snapshotOf.size()) {
+                    snapshotOf[ev.object] = -1;
+                }
+            }
+        }
+
+        // Check the accesses, one shard per thread
+        if (options.maxRaces > 0) {
+            shardOptions.maxRaces = options.maxRaces - result.races.size();
+        }
+        context.runAll([&](int i) { shards[i].run(state, snapshots, shardOptions); });
+        for (auto& shard : shards) {
+            if (shard.error) {
+                std::rethrow_exception(shard.error);
+            }
+        }
+
+        // Merge the races in trace order, stopping where detectEvents would
+        std::vector<std::pair<std::size_t, Race>> found;
+        for (auto& shard : shards) {
+            for (std::size_t i = 0; i < shard.result.races.size(); ++i) {
+                found.emplace_back(shard.racePositions[i], shard.result.races[i]);
+            }
+            shard.result.races.clear();
+            shard.racePositions.clear();
+        }
+        std::stable_sort(found.begin(), found.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        result.position = windowStart + offset;
+        for (const auto& [position, race] : found) {
+            result.races.push_back(race);
+            if (!options.collectAll || (options.maxRaces > 0 && result.races.size() >= options.maxRaces)) {
+                result.stopped = true;
+                result.position = position;
+                break;
+            }
+        }
+    }
+
+    // Write the shadows back, on the workers where no allocation is needed
+    context.runAll([&](int i) { shards[i].storeLoaded(state); });
+    for (auto& shard : shards) {
+        for (int id : shard.unstored()) {
+            shard.store(state, result, id);
+        }
+        if (options.dedupe != RaceKey::None) {
+            result.seen.merge(shard.result.seen);
+        }
+        shard.result.seen = RaceSet();
+    }
+}
+
+#endif
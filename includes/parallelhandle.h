@@ -0,0 +1,27 @@
+#ifndef PARALLELHANDLE_H
+#define PARALLELHANDLE_H
+
+#include <memory>
+
+class ParallelContext;
+
+// The ParallelContext (see parallel.h) a state keeps for detectParallel
+// between calls. The context only holds scratch buffers and idle worker
+// threads, never shadow state, so a copy of the handle starts empty.
+class ParallelHandle {
+    std::shared_ptr<ParallelContext> context;
+public:
+    ParallelHandle() = default;
+    ParallelHandle(const ParallelHandle&) {}
+    ParallelHandle& operator=(const ParallelHandle&) {
+        context.reset();
+        return *this;
+    }
+    ParallelHandle(ParallelHandle&&) noexcept = default;
+    ParallelHandle& operator=(ParallelHandle&&) noexcept = default;
+
+    // The context, created on first use
+    ParallelContext& get();
+};
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "event.h"
+#include "race.h"
+#include "run.h"
+#include "shadowmemory.h"
+#include "spscring.h"
+#include "symboltable.h"
+#include "texttrace.h"
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Pipelined version of runTextTrace. A reader thread reads and decodes the
+// trace into batches of compact events while the calling thread checks the
+// previous batches, and an optional third thread hands races to a callback
+// as they are found. The stages are connected by SpscRings; batch buffers
+// travel back to the reader on a second ring, so the steady state does not
+// allocate.
+//
+// The reader cannot intern names into the target while the detector is
+// using it, so it interns into a TraceCatalog seeded from the target's
+// tables instead. Each batch carries the threads, locks and locations first
+// seen in it, and the detector stage declares them on the target, in the
+// same order, before checking the batch; both sides therefore hand out the
+// same IDs. The races and RunResult are those of runTextTrace.
+
+// Objects introduced by one batch, in first-use order
+struct TraceDeclaration {
+    enum class Kind { Thread, Lock, Location, Address };
+    Kind kind;
+    int id;
+    std::string name;
+    std::uint64_t address = 0;   // granule of an Address
+};
+
+struct TraceBatch {
+    std::vector<Event> events;
+    std::vector<TraceDeclaration> declarations;
+};
+
+// Naming side of the target interface, used by the reader thread. Interns
+// into its own tables and records every new object in the current batch.
+class TraceCatalog {
+    SymbolTable lockSymbols;
+    SymbolTable locationSymbols;
+    ShadowMemory addresses;
+    int threads;
+    std::vector<TraceDeclaration>* pending = nullptr;
+
+    int declare(TraceDeclaration::Kind kind, SymbolTable& symbols, std::string_view name) {
+        const int before = symbols.size();
+        const int id = symbols.intern(name);
+        if (id == before) {
+            pending->push_back(TraceDeclaration{kind, id, std::string(name)});
+        }
+        return id;
+    }
+public:
+    template <typename Target>
+    explicit TraceCatalog(const Target& target)
+        : lockSymbols(target.locks()), locationSymbols(target.locations()),
+          addresses(target.addressGranularity()), threads(target.numThreads()) {
+        // Addresses the target has already mapped keep their IDs
+        for (int id = 0; id < locationSymbols.size(); ++id) {
+            if (locationSymbols.isAddress(id)) {
+                addresses.cell(locationSymbols.address(id)) = id + 1;
+            }
+        }
+    }
+
+    // Record the declarations of the next events into batch
+    void startBatch(TraceBatch& batch) {
+        batch.declarations.clear();
+        pending = &batch.declarations;
+    }
+
+    int addThread(int index) {
+        if (index >= threads) {
+            threads = index + 1;
+            pending->push_back(TraceDeclaration{TraceDeclaration::Kind::Thread, index, std::string()});
+        }
+        return index;
+    }
+    int addLock(std::string_view name) { return declare(TraceDeclaration::Kind::Lock, lockSymbols, name); }
+    int locationId(std::string_view name) { return declare(TraceDeclaration::Kind::Location, locationSymbols, name); }
+    int addressId(std::uint64_t address) {
+        int& cell = addresses.cell(address);
+        if (cell == 0) {
+            const std::uint64_t granule = addresses.granule(address);
+            cell = locationSymbols.addAddress(granule) + 1;
+            pending->push_back(TraceDeclaration{TraceDeclaration::Kind::Address, cell - 1, std::string(), granule});
+        }
+        return cell - 1;
+    }
+};
+
+// Declare on target the objects a batch introduced
+template <typename Target>
+void declare(Target& target, const std::vector<TraceDeclaration>& declarations) {
+    for (const TraceDeclaration& d : declarations) {
+        int id;
+        switch (d.kind) {
+            case TraceDeclaration::Kind::Thread:
+                id = target.addThread(d.id);
+                break;
+            case TraceDeclaration::Kind::Lock:
+                id = target.addLock(d.name);
+                break;
+            case TraceDeclaration::Kind::Location:
+                id = target.locationId(d.name);
+                break;
+            case TraceDeclaration::Kind::Address:
+                id = target.addressId(d.address);
+                break;
+        }
+        assert(id == d.id);
+        (void)id;
+    }
+}
+
+struct PipelineOptions {
+    std::size_t batchSize = TEXT_TRACE_BATCH_SIZE;
+    // Batches in flight between the reader and the detector
+    std::size_t depth = 8;
+    // If set, called on a separate thread with each race and its printed form.
+    // An exception it throws stops the run and is rethrown to the caller.
+    std::function<void(const Race&, const std::string&)> onRace;
+};
+
+template <typename Target>
+RunResult runTextTracePipelined(Target& target, std::istream& in, const RunOptions& options = RunOptions(),
+                                const PipelineOptions& pipeline = PipelineOptions()) {
+    const std::size_t depth = pipeline.depth < 2 ? 2 : pipeline.depth;
+    SpscRing<TraceBatch> full(depth), empty(depth);
+    for (std::size_t i = 0; i < full.capacity(); ++i) {
+        TraceBatch batch;
+        batch.events.reserve(pipeline.batchSize);
+        empty.tryPush(batch);
+    }
+
+    // Reader stage
+    TraceCatalog catalog(target);
+    std::atomic<bool> cancel{false};
+    std::exception_ptr readError;
+    std::thread reader([&] {
+        try {
+            TextTraceReader decoder(in);
+            TraceBatch batch;
+            while (!cancel.load(std::memory_order_relaxed) && empty.pop(batch)) {
+                catalog.startBatch(batch);
+                if (!decoder.nextBatch(catalog, batch.events, pipeline.batchSize) || !full.push(batch)) {
+                    break;
+                }
+            }
+        } catch (...) {
+            readError = std::current_exception();
+        }
+        full.close();
+    });
+
+    // Report stage
+    struct Report {
+        Race race;
+        std::string text;
+    };
+    SpscRing<Report> reports(1024);
+    std::exception_ptr reportError;
+    std::atomic<bool> reportFailed{false};
+    std::thread reporter;
+    if (pipeline.onRace) {
+        reporter = std::thread([&] {
+            try {
+                Report report;
+                while (reports.pop(report)) {
+                    pipeline.onRace(report.race, report.text);
+                }
+            } catch (...) {
+                reportError = std::current_exception();
+                reportFailed.store(true, std::memory_order_relaxed);
+                reports.close();
+            }
+        });
+    }
+    auto finish = [&] {
+        cancel.store(true, std::memory_order_relaxed);
+        // The reader may be waiting on either ring
+        empty.close();
+        full.close();
+        reader.join();
+        reports.close();
+        if (reporter.joinable()) {
+            reporter.join();
+        }
+    };
+
+    // Detector stage
+    RunResult result;
+    try {
+        TraceBatch batch;
+        std::size_t reported = 0;
+        while (!reportFailed.load(std::memory_order_relaxed) && full.pop(batch)) {
+            if (!result.stopped) {
+                declare(target, batch.declarations);
+                detect(target, batch.events.data(), batch.events.data() + batch.events.size(), options, result);
+                if (pipeline.onRace) {
+                    for (; reported < result.races.size(); ++reported) {
+                        Report report{result.races[reported], result.races[reported].toString(target.locations())};
+                        if (!reports.push(report)) {
+                            break;
+                        }
+                    }
+                }
+                if (result.stopped) {
+                    cancel.store(true, std::memory_order_relaxed);
+                }
+            }
+            empty.push(batch);
+        }
+    } catch (...) {
+        finish();
+        throw;
+    }
+    finish();
+    if (reportError) {
+        std::rethrow_exception(reportError);
+    }
+    if (readError && !result.stopped) {
+        std::rethrow_exception(readError);
+    }
+    return result;
+}
+
+#endif
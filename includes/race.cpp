@@ -1,58 +1,20 @@
+#include "race.h"
 #include <iostream>
 #include <string>
-#include "instructions.h"
 
-class Race {
-public:
-    virtual ~Race() = default;
-    virtual void print(std::ostream& os) const = 0;
-};
-
-std::ostream& operator<<(std::ostream& os, const Race& race) {
-    race.print(os);
-    return os;
-}
-
-class ReadWriteRace : public Race {
-private:
-    int u;
-    int t;
-    std::string x;
-
-public:
-    ReadWriteRace(int u, int t, std::string x) : u(u), t(t), x(std::move(x)) {}
-    void print(std::ostream& os) const override {
-        os << "ReadWriteRace(" << u << ", " << t << ", " << x << ")";
-    }
-};
-
-class WriteWriteRace : public Race {
-private:
-    int u;
-    int t;
-    std::string x;
-
-public:
-    WriteWriteRace(int u, int t, std::string x) : u(u), t(t), x(std::move(x)) {}
-    void print(std::ostream& os) const override {
-        os << "WriteWriteRace(" << u << ", " << t << ", " << x << ")";
+const char* raceTypeName(RaceType type) {
+    switch (type) {
+    case RaceType::ReadWrite:  return "ReadWriteRace";
+    case RaceType::WriteWrite: return "WriteWriteRace";
+    case RaceType::WriteRead:  return "WriteReadRace";
     }
-};
-
-class WriteReadRace : public Race {
-private:
-    int u;
-    int t;
-    std::string x;
+    return "UnknownRace";
+}
 
-public:
-    WriteReadRace(int u, int t, std::string x) : u(u), t(t), x(std::move(x)) {}
-    void print(std::ostream& os) const override {
-        os << "WriteReadRace(" << u << ", " << t << ", " << x << ")";
-    }
-};
+void Race::print(std::ostream& os, const SymbolTable& locations) const {
+    os << raceTypeName(type) << "(" << u << ", " << t << ", " << locations.name(location) << ")";
+}
 
-std::ostream& operator<<(std::ostream& os, const Instruction& instr) {
-    instr.print(os);  // Call the virtual print method
-    return os;
-}
\ No newline at end of file
+std::string Race::toString(const SymbolTable& locations) const {
+    return std::string(raceTypeName(type)) + "(" + std::to_string(u) + ", " + std::to_string(t) + ", " + locations.name(location) + ")";
+}
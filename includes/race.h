@@ -1,34 +1,34 @@
+#ifndef RACE_H
+#define RACE_H
+
+#include "symboltable.h"
+#include <cstdint>
 #include <iostream>
 #include <string>
 
-class Race {
-public:
-    virtual ~Race() {}
-    virtual void print(std::ostream& os) const = 0;
+enum class RaceType : std::uint8_t {
+    ReadWrite,   // earlier read by u, write by t
+    WriteWrite,  // earlier write by u, write by t
+    WriteRead,   // earlier write by u, read by t
 };
 
-class ReadWriteRace : public Race {
-    int u, t;
-    std::string x;
-public:
-    ReadWriteRace(int u, int t, std::string x);
-    void print(std::ostream& os) const override;
-};
+// A race between the earlier access of thread u and the current access of
+// thread t to a location, identified by its ID in the state's location table.
+struct Race {
+    RaceType type;
+    int u;
+    int t;
+    int location;
 
-class WriteWriteRace : public Race {
-    int u, t;
-    std::string x;
-public:
-    WriteWriteRace(int u, int t, std::string x);
-    void print(std::ostream& os) const override;
-};
+    // Prints e.g. ReadWriteRace(0, 1, x)
+    void print(std::ostream& os, const SymbolTable& locations) const;
+    std::string toString(const SymbolTable& locations) const;
 
-class WriteReadRace : public Race {
-    int u, t;
-    std::string x;
-public:
-    WriteReadRace(int u, int t, std::string x);
-    void print(std::ostream& os) const override;
+    bool operator==(const Race& other) const {
+        return type == other.type && u == other.u && t == other.t && location == other.location;
+    }
 };
 
-std::ostream& operator<<(std::ostream& os, const Race& race);
+const char* raceTypeName(RaceType type);
+
+#endif
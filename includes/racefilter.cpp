@@ -0,0 +1,138 @@
+#include "racefilter.h"
+#include <fstream>
+#include <stdexcept>
+
+static std::uint64_t mix(std::uint64_t high, std::uint64_t low) {
+    std::uint64_t h = high * 0x9E3779B97F4A7C15ull ^ low;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    return h ^ (h >> 32);
+}
+
+bool RaceSet::insert(const Race& race, RaceKey key) {
+    Slot slot;
+    slot.high = static_cast<std::uint64_t>(static_cast<std::uint32_t>(race.location)) << 8;
+    if (key != RaceKey::Location) {
+        slot.high |= static_cast<std::uint64_t>(race.type);
+    }
+    if (key == RaceKey::Race) {
+        slot.low = static_cast<std::uint64_t>(static_cast<std::uint32_t>(race.u)) << 32 |
+                   static_cast<std::uint32_t>(race.t);
+    }
+    if (base && base->contains(slot)) {
+        return false;
+    }
+    return insert(slot);
+}
+
+bool RaceSet::contains(const Slot& key) const {
+    if (slots.empty()) {
+        return false;
+    }
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = mix(key.high, key.low) & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (slot.high == EMPTY) {
+            return false;
+        }
+        if (slot.high == key.high && slot.low == key.low) {
+            return true;
+        }
+    }
+}
+
+bool RaceSet::insert(const Slot& key) {
+    // Keep the load factor at or below 1/2
+    if (2 * (count + 1) > slots.size()) {
+        grow();
+    }
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = mix(key.high, key.low) & mask;; i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        if (slot.high == EMPTY) {
+            slot = key;
+            ++count;
+            return true;
+        }
+        if (slot.high == key.high && slot.low == key.low) {
+            return false;
+        }
+    }
+}
+
+void RaceSet::grow() {
+    std::vector<Slot> old(slots.size() ? slots.size() * 2 : 16);
+    old.swap(slots);
+    count = 0;
+    for (const Slot& slot : old) {
+        if (slot.high != EMPTY) {
+            insert(slot);
+        }
+    }
+}
+
+void RaceSet::merge(const RaceSet& other) {
+    for (const Slot& slot : other.slots) {
+        if (slot.high != EMPTY) {
+            insert(slot);
+        }
+    }
+}
+
+Suppressions Suppressions::fromFile(const std::string& path, bool skipChecks) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot read suppressions from " + path);
+    }
+    Suppressions suppressions(skipChecks);
+    suppressions.read(in);
+    return suppressions;
+}
+
+void Suppressions::read(std::istream& in) {
+    std::string line;
+    while (std::getline(in, line)) {
+        const auto begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+        const auto end = line.find_last_not_of(" \t\r");
+        add(line.substr(begin, end - begin + 1));
+    }
+}
+
+void Suppressions::add(const std::string& pattern) {
+    if (!pattern.empty() && pattern.back() == '*') {
+        prefixes.push_back(pattern.substr(0, pattern.size() - 1));
+    } else {
+        names.insert(pattern);
+    }
+    // Recompile everything against the new pattern on the next update
+    compiled = 0;
+}
+
+bool Suppressions::matches(const std::string& name) const {
+    if (names.count(name)) {
+        return true;
+    }
+    for (const auto& p : prefixes) {
+        if (name.compare(0, p.size(), p) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Suppressions::update(const SymbolTable& locations) {
+    const int size = locations.size();
+    if (compiled >= size) {
+        return;
+    }
+    bits.resize((static_cast<std::size_t>(size) + 63) / 64, 0);
+    for (int id = compiled; id < size; ++id) {
+        if (matches(locations.name(id))) {
+            bits[id >> 6] |= std::uint64_t(1) << (id & 63);
+        }
+    }
+    compiled = size;
+}
@@ -0,0 +1,92 @@
+#ifndef RACEFILTER_H
+#define RACEFILTER_H
+
+#include "race.h"
+#include "symboltable.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// What makes two races the same for RunOptions::dedupe
+enum class RaceKey : std::uint8_t {
+    None,           // keep every race
+    Race,           // type, location and both threads
+    TypeLocation,   // type and location
+    Location,       // location only: one race per location
+};
+
+// Set of race keys already reported. Open addressing with linear probing
+// over 16-byte slots; the key is stored exactly, so distinct races never
+// collide. Every key includes the location, so the sets of workers that
+// own disjoint locations can be merged without losing anything.
+class RaceSet {
+    struct Slot {
+        std::uint64_t high = EMPTY;   // location and type
+        std::uint64_t low = 0;        // thread pair
+    };
+    static constexpr std::uint64_t EMPTY = ~std::uint64_t(0);
+
+    std::vector<Slot> slots;    // size is zero or a power of two
+    std::size_t count = 0;
+    const RaceSet* base = nullptr;
+
+    bool insert(const Slot& key);
+    bool contains(const Slot& key) const;
+    void grow();
+public:
+    // Record race under key; returns false if an equal one was already seen
+    bool insert(const Race& race, RaceKey key);
+    // Merge the keys held by other itself, not those of its base
+    void merge(const RaceSet& other);
+    std::size_t size() const { return count; }
+
+    // Treat the keys of base as seen too, without copying them. base must
+    // outlive this set and not change while it is in use; pass nullptr to
+    // detach.
+    void layerOver(const RaceSet* set) { base = set; }
+};
+
+// Locations whose races are known to be benign. Read one name per line; a
+// trailing '*' matches every name with that prefix, and blank lines and
+// lines starting with '#' are skipped:
+//
+//   # stats counters are updated racily on purpose
+//   hits
+//   stats.*
+//   0x7ffd1000
+//
+// The patterns are compiled into a bitset over the location IDs of one
+// state, so an instance must not be shared between states. IDs interned
+// after the last update() are not covered until the next one; the engine
+// updates at the start of every detect call. Races on suppressed locations
+// are never reported, and with skipChecks their accesses are not checked
+// (or shadowed) at all.
+class Suppressions {
+    std::unordered_set<std::string> names;
+    std::vector<std::string> prefixes;
+    std::vector<std::uint64_t> bits;
+    int compiled = 0;
+    bool skip;
+
+    bool matches(const std::string& name) const;
+public:
+    explicit Suppressions(bool skipChecks = false) : skip(skipChecks) {}
+    // Throws std::runtime_error if path cannot be read
+    static Suppressions fromFile(const std::string& path, bool skipChecks = false);
+
+    void read(std::istream& in);
+    void add(const std::string& pattern);
+
+    // Compile the patterns against locations added since the last update
+    void update(const SymbolTable& locations);
+
+    bool contains(int location) const {
+        const std::size_t word = static_cast<std::size_t>(location) >> 6;
+        return word < bits.size() && (bits[word] >> (location & 63) & 1);
+    }
+    bool skipChecks() const { return skip; }
+};
+
+#endif
@@ -2,8 +2,10 @@
 #define RUN_H
 
 #include "instructions.h"
+#include "event.h"
 #include "vectorclockstate.h"
 #include "race.h"
+#include "detect.h"
 #include <vector>
 #include <iostream>
 #include <algorithm>
@@ -11,13 +13,27 @@
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <cstddef>
 
-std::tuple<VectorClockState, std::unique_ptr<Race>> run(VectorClockState& state, const std::vector<std::shared_ptr<Instruction>>& program, bool verbose);
+// Intern the names used by program into state and encode it as compact events
+std::vector<Event> lower(VectorClockState& state, const std::vector<std::shared_ptr<Instruction>>& program);
+
+// Analyse [begin, end) in place, appending to result. Can be called on
+// consecutive chunks of one trace (e.g. a MappedTrace or a streamed text
+// trace) with the same result, until result.stopped is set.
+void detect(VectorClockState& state, const Event* begin, const Event* end, const RunOptions& options, RunResult& result);
+
+RunResult run(VectorClockState& state, const Event* begin, const Event* end, const RunOptions& options = RunOptions());
+RunResult run(VectorClockState& state, const std::vector<Event>& events, const RunOptions& options = RunOptions());
+RunResult run(VectorClockState& state, const std::vector<std::shared_ptr<Instruction>>& program, const RunOptions& options = RunOptions());
+RunResult run(VectorClockState& state, const std::vector<std::shared_ptr<Instruction>>& program, bool verbose);
 
 // int initialVectorClockState(const VectorClock& location_vec, const VectorClock& clock_vec);
 
-VectorClockState initialVectorClockState(int num_threads, const std::vector<std::string>& locks, 
-                                         const std::vector<std::string>& atomic_objects, 
-                                         const std::vector<std::string>& shared_locations);
+// Objects need not be declared up front; undeclared ones get their shadow
+// on first touch, so initialVectorClockState(n) is enough for any trace.
+VectorClockState initialVectorClockState(int num_threads, const std::vector<std::string>& locks = {},
+                                         const std::vector<std::string>& atomic_objects = {},
+                                         const std::vector<std::string>& shared_locations = {});
 
-#endif
\ No newline at end of file
+#endif
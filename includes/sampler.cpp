@@ -0,0 +1,91 @@
+#include "sampler.h"
+#include <cmath>
+#include <stdexcept>
+
+Sampler::Sampler(double minRate, double decay, std::uint64_t seed) : seed(seed) {
+    if (!(minRate > 0 && minRate <= 1)) {
+        throw std::invalid_argument("Sampling rate must be in (0, 1]");
+    }
+    if (!(decay > 0 && decay < 1)) {
+        throw std::invalid_argument("Sampling decay must be in (0, 1)");
+    }
+    for (double rate = 1;; rate *= decay) {
+        if (rate <= minRate) {
+            periods.push_back(static_cast<std::uint32_t>(std::lround(1 / minRate)));
+            break;
+        }
+        periods.push_back(static_cast<std::uint32_t>(std::lround(1 / rate)));
+    }
+}
+
+Sampler::ThreadSampler& Sampler::thread(int t) {
+    if (static_cast<std::size_t>(t) >= threads.size()) {
+        const std::size_t old = threads.size();
+        threads.resize(t + 1);
+        for (std::size_t u = old; u < threads.size(); ++u) {
+            // Distinct nonzero xorshift seeds per thread
+            threads[u].random = (seed + u) * 0x9E3779B97F4A7C15ull | 1;
+        }
+    }
+    return threads[t];
+}
+
+void Sampler::grow(ThreadSampler& ts, int location) {
+    std::size_t size = ts.rates.empty() ? 1 : ts.rates.size();
+    while (size <= static_cast<std::size_t>(location) && size < SAMPLER_RATE_SLOTS) {
+        size *= 2;
+    }
+    // Slots that were distinct stay distinct under the wider mask
+    std::vector<Rate> rates(size);
+    for (const Rate& r : ts.rates) {
+        if (r.location >= 0) {
+            rates[r.location & (size - 1)] = r;
+        }
+    }
+    ts.rates.swap(rates);
+}
+
+std::uint32_t Sampler::gap(ThreadSampler& ts, std::uint32_t period) {
+    if (period <= 1) {
+        return 0;
+    }
+    std::uint64_t& x = ts.random;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    // Uniform over [0, 2 * (period - 1)], so the mean distance is period
+    return static_cast<std::uint32_t>(x % (2 * std::uint64_t(period) - 1));
+}
+
+std::uint64_t Sampler::accesses() const {
+    std::uint64_t sum = 0;
+    for (const auto& ts : threads) {
+        sum += ts.accesses;
+    }
+    return sum;
+}
+
+std::uint64_t Sampler::checked() const {
+    std::uint64_t sum = 0;
+    for (const auto& ts : threads) {
+        sum += ts.checked;
+    }
+    return sum;
+}
+
+double Sampler::coverage() const {
+    const std::uint64_t total = accesses();
+    return total ? static_cast<double>(checked()) / total : 1.0;
+}
+
+double Sampler::coverage(int t) const {
+    if (t < 0 || static_cast<std::size_t>(t) >= threads.size() || threads[t].accesses == 0) {
+        return 1.0;
+    }
+    return static_cast<double>(threads[t].checked) / threads[t].accesses;
+}
+
+std::ostream& operator<<(std::ostream& os, const Sampler& sampler) {
+    return os << "accesses: " << sampler.accesses() << ", checked: " << sampler.checked()
+              << " (coverage " << 100 * sampler.coverage() << "%)";
+}
@@ -0,0 +1,85 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Adaptive access sampling for RunOptions::sampler, after LiteRace. Sync
+// events are always applied, so clocks stay exact; only Read/Write checks
+// are sampled. Each thread keeps a rate per location: the first access is
+// always checked, and every checked access divides the rate by 1/decay,
+// down to minRate. Cold code is therefore checked closely and hot loops
+// rarely. The gap to the next checked access is drawn at random around the
+// mean 1/rate, so that periodic access patterns are not aliased.
+//
+// The rates of a thread live in a table indexed by location ID modulo its
+// size, which grows to at most SAMPLER_RATE_SLOTS entries. A location whose
+// slot was taken by another one starts over as if never accessed, so a
+// collision only adds checks.
+//
+// Skipping an access only leaves its shadow update out, so sampling can
+// miss races but never reports a false one. Coverage is the fraction of
+// accesses actually checked.
+constexpr std::size_t SAMPLER_RATE_SLOTS = std::size_t(1) << 14;
+
+class Sampler {
+    struct Rate {
+        int location = -1;        // location owning the slot, or -1
+        std::uint32_t skip = 0;   // accesses left before the next check
+        std::uint32_t level = 0;  // index into periods
+    };
+    struct alignas(64) ThreadSampler {
+        std::vector<Rate> rates;  // by location ID modulo the size, a power of two
+        std::uint64_t random;
+        std::uint64_t accesses = 0;
+        std::uint64_t checked = 0;
+    };
+
+    std::vector<std::uint32_t> periods;   // mean distance between checks by level
+    std::vector<ThreadSampler> threads;
+    std::uint64_t seed;
+
+    ThreadSampler& thread(int t);
+    void grow(ThreadSampler& ts, int location);
+    std::uint32_t gap(ThreadSampler& ts, std::uint32_t period);
+public:
+    // Throws std::invalid_argument unless 0 < minRate <= 1 and 0 < decay < 1
+    explicit Sampler(double minRate = 0.001, double decay = 0.1, std::uint64_t seed = 1);
+
+    // Whether thread t's access to location should be checked
+    bool sample(int t, int location) {
+        ThreadSampler& ts = thread(t);
+        ++ts.accesses;
+        if (static_cast<std::size_t>(location) >= ts.rates.size() && ts.rates.size() < SAMPLER_RATE_SLOTS) {
+            grow(ts, location);
+        }
+        Rate& r = ts.rates[location & (ts.rates.size() - 1)];
+        if (r.location != location) {
+            r = Rate{location};
+        }
+        if (r.skip > 0) {
+            --r.skip;
+            return false;
+        }
+        ++ts.checked;
+        if (r.level + 1 < periods.size()) {
+            ++r.level;
+        }
+        r.skip = gap(ts, periods[r.level]);
+        return true;
+    }
+
+    std::uint64_t accesses() const;
+    std::uint64_t checked() const;
+    // checked() / accesses(), or 1 before any access
+    double coverage() const;
+    // The same for the accesses of thread t
+    double coverage(int t) const;
+};
+
+// "accesses: N, checked: M (coverage 12.5%)"
+std::ostream& operator<<(std::ostream& os, const Sampler& sampler);
+
+#endif
@@ -0,0 +1,115 @@
+#include "shadowmemory.h"
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+
+static constexpr std::size_t LEAF_BYTES = (std::size_t(1) << ShadowMemory::LEAF_BITS) * sizeof(int);
+
+// Zero-filled, lazily backed anonymous mapping
+static void* reserve(std::size_t bytes) {
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+ShadowMemory::ShadowMemory(int granularity) {
+    switch (granularity) {
+    case 1: shift = 0; break;
+    case 4: shift = 2; break;
+    case 8: shift = 3; break;
+    default:
+        throw std::invalid_argument("Shadow granularity must be 1, 4 or 8 bytes, not " + std::to_string(granularity));
+    }
+}
+
+ShadowMemory::ShadowMemory(const ShadowMemory& other) : shift(other.shift) {
+    for (std::size_t hi : other.leaves) {
+        std::memcpy(addLeaf(hi), other.top[hi], LEAF_BYTES);
+    }
+}
+
+ShadowMemory::ShadowMemory(ShadowMemory&& other) noexcept
+    : shift(other.shift), top(other.top), leaves(std::move(other.leaves)) {
+    other.top = nullptr;
+    other.leaves.clear();
+}
+
+ShadowMemory& ShadowMemory::operator=(const ShadowMemory& other) {
+    if (this != &other) {
+        ShadowMemory copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+ShadowMemory& ShadowMemory::operator=(ShadowMemory&& other) noexcept {
+    if (this != &other) {
+        release();
+        shift = other.shift;
+        top = other.top;
+        leaves = std::move(other.leaves);
+        other.top = nullptr;
+        other.leaves.clear();
+    }
+    return *this;
+}
+
+ShadowMemory::~ShadowMemory() {
+    release();
+}
+
+std::size_t ShadowMemory::topEntries() const {
+    return std::size_t(1) << (ADDRESS_BITS - shift - LEAF_BITS);
+}
+
+std::size_t ShadowMemory::bytes() const {
+    return leaves.size() * LEAF_BYTES;
+}
+
+int* ShadowMemory::addLeaf(std::size_t hi) {
+    if (!top) {
+        top = static_cast<int**>(reserve(topEntries() * sizeof(int*)));
+    }
+    int* leaf = static_cast<int*>(reserve(LEAF_BYTES));
+    leaves.push_back(hi);
+    top[hi] = leaf;
+    return leaf;
+}
+
+void ShadowMemory::outOfRange(std::uint64_t address) const {
+    throw std::out_of_range("Address " + addressName(address) + " is outside the " +
+                            std::to_string(ADDRESS_BITS) + "-bit shadow range");
+}
+
+void ShadowMemory::release() {
+    if (!top) {
+        return;
+    }
+    for (std::size_t hi : leaves) {
+        ::munmap(top[hi], LEAF_BYTES);
+    }
+    ::munmap(top, topEntries() * sizeof(int*));
+    top = nullptr;
+    leaves.clear();
+}
+
+std::string addressName(std::uint64_t address) {
+    static const char digits[] = "0123456789abcdef";
+    char buffer[2 + 16];
+    char* end = buffer + sizeof(buffer);
+    char* p = end;
+    do {
+        *--p = digits[address & 0xf];
+        address >>= 4;
+    } while (address);
+    *--p = 'x';
+    *--p = '0';
+    return std::string(p, end);
+}
@@ -0,0 +1,70 @@
+#ifndef SHADOWMEMORY_H
+#define SHADOWMEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Direct-mapped table from memory addresses to location IDs, for traces
+// that identify locations by address rather than by name. Addresses are
+// split into granules of 1, 4 or 8 bytes; all accesses to one granule share
+// a location.
+//
+// The table has two levels indexed straight from the granule number, so a
+// lookup is two loads with no hashing. The top level covers the whole
+// 48-bit user address space and each leaf covers 2^LEAF_BITS granules. Both
+// are reserved with mmap and backed by the kernel only where touched, so
+// memory grows with the pages of the address space a trace actually uses.
+class ShadowMemory {
+public:
+    static constexpr int ADDRESS_BITS = 48;
+    static constexpr int LEAF_BITS = 20;
+
+    // Throws std::invalid_argument unless granularity is 1, 4 or 8
+    explicit ShadowMemory(int granularity = 8);
+    ShadowMemory(const ShadowMemory& other);
+    ShadowMemory(ShadowMemory&& other) noexcept;
+    ShadowMemory& operator=(const ShadowMemory& other);
+    ShadowMemory& operator=(ShadowMemory&& other) noexcept;
+    ~ShadowMemory();
+
+    int granularity() const { return 1 << shift; }
+    // First address of the granule holding address
+    std::uint64_t granule(std::uint64_t address) const { return address >> shift << shift; }
+
+    // Cell of address: the location ID + 1, or 0 if never assigned. Creates
+    // the leaf on first touch; throws std::out_of_range past ADDRESS_BITS.
+    int& cell(std::uint64_t address) {
+        if (address >> ADDRESS_BITS) {
+            outOfRange(address);
+        }
+        const std::uint64_t g = address >> shift;
+        const std::size_t hi = static_cast<std::size_t>(g >> LEAF_BITS);
+        int* leaf = top ? top[hi] : nullptr;
+        if (!leaf) {
+            leaf = addLeaf(hi);
+        }
+        return leaf[g & ((std::uint64_t(1) << LEAF_BITS) - 1)];
+    }
+
+    // True once any address has been mapped
+    bool used() const { return !leaves.empty(); }
+
+    // Bytes of leaves reserved so far (an upper bound on resident memory)
+    std::size_t bytes() const;
+private:
+    int shift;
+    int** top = nullptr;
+    std::vector<std::size_t> leaves;    // top-level indices with a leaf
+
+    std::size_t topEntries() const;
+    int* addLeaf(std::size_t hi);
+    [[noreturn]] void outOfRange(std::uint64_t address) const;
+    void release();
+};
+
+// Canonical name of an address location, e.g. "0x7ffd1000"
+std::string addressName(std::uint64_t address);
+
+#endif
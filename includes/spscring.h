@@ -0,0 +1,99 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread. Values are moved in and out, so a ring of batches hands
+// over their buffers without copying. The two indices live on separate
+// cache lines, and each side keeps a private copy of the other's index so
+// that it only reads the shared one when the ring looks full or empty.
+//
+// close() ends the stream: pop() drains what is left and then returns
+// false, and push() gives up instead of waiting for space.
+template <typename T>
+class SpscRing {
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    std::vector<T> slots;
+    std::size_t mask;
+
+    alignas(CACHE_LINE) std::atomic<std::size_t> head{0};  // next slot to pop; written by the consumer
+    std::size_t cachedTail = 0;                              // consumer's view of tail
+    alignas(CACHE_LINE) std::atomic<std::size_t> tail{0};  // next slot to push; written by the producer
+    std::size_t cachedHead = 0;                              // producer's view of head
+    alignas(CACHE_LINE) std::atomic<bool> closed{false};
+
+    static std::size_t roundUp(std::size_t n) {
+        std::size_t size = 1;
+        while (size < n) size <<= 1;
+        return size;
+    }
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(std::size_t capacity) : slots(roundUp(capacity)), mask(slots.size() - 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return slots.size(); }
+
+    // Producer: move value in if there is room
+    bool tryPush(T& value) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == slots.size()) {
+                return false;
+            }
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: move the oldest value out if there is one
+    bool tryPop(T& value) {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) {
+                return false;
+            }
+        }
+        value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: wait for room; false if the ring was closed first
+    bool push(T& value) {
+        while (!tryPush(value)) {
+            if (closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // Consumer: wait for a value; false once the ring is closed and drained
+    bool pop(T& value) {
+        while (!tryPop(value)) {
+            if (closed.load(std::memory_order_acquire)) {
+                return tryPop(value);
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // Either side: no more values will be pushed
+    void close() { closed.store(true, std::memory_order_release); }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef STATICVECTORCLOCK_H
+#define STATICVECTORCLOCK_H
+
+#include "clockkernels.h"
+#include "stats.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+
+// Vector clock for a thread count N fixed at compile time. Same interface as
+// VectorClock, but entries live in a std::array and every loop has a
+// constant trip count, so the compiler fully unrolls and vectorizes join and
+// compare. Threads beyond the ones in use keep a zero entry.
+template <int N>
+class StaticVectorClock {
+public:
+    static constexpr int PADDED = static_cast<int>(paddedWidth(N));
+
+private:
+    alignas(CLOCK_ALIGNMENT) std::array<int, PADDED> entries{};
+
+public:
+    StaticVectorClock() = default;
+    explicit StaticVectorClock(int num_threads) { assert(num_threads <= N); (void)num_threads; }
+
+    static constexpr int size() { return N; }
+    const int* data() const { return entries.data(); }
+
+    StaticVectorClock& increment(int index) {
+        if (index >= 0 && index < N) {
+            entries[index]++;
+        }
+        return *this;
+    }
+
+    int operator[](size_t index) const { return entries[index]; }
+    int& operator[](size_t index) { return entries[index]; }
+
+    bool operator<=(const StaticVectorClock& other) const {
+        DETECTOR_STAT(countClockOp(Counter::Compares, PADDED));
+        bool leq = true;
+        for (int i = 0; i < PADDED; ++i) {
+            leq &= entries[i] <= other.entries[i];
+        }
+        return leq;
+    }
+
+    // In-place join target := max(target, *this)
+    void joinInto(StaticVectorClock& target) const {
+        DETECTOR_STAT(countClockOp(Counter::Joins, PADDED));
+        for (int i = 0; i < PADDED; ++i) {
+            target.entries[i] = std::max(target.entries[i], entries[i]);
+        }
+    }
+
+    StaticVectorClock& assignFrom(const StaticVectorClock& other) {
+        DETECTOR_STAT(countClockOp(Counter::Copies, PADDED));
+        entries = other.entries;
+        return *this;
+    }
+
+    // Smallest index whose entry exceeds other's, or -1 if *this <= other
+    int findGreater(const StaticVectorClock& other) const {
+        DETECTOR_STAT(countClockOp(Counter::Compares, N));
+        for (int i = 0; i < N; ++i) {
+            if (entries[i] > other.entries[i]) return i;
+        }
+        return -1;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const StaticVectorClock& vc) {
+        os << '[';
+        for (int i = 0; i < N; i++) {
+            os << vc.entries[i];
+            if (i < N - 1) os << ", ";
+        }
+        os << ']';
+        return os;
+    }
+};
+
+#endif
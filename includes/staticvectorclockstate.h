@@ -0,0 +1,300 @@
+#ifndef STATICVECTORCLOCKSTATE_H
+#define STATICVECTORCLOCKSTATE_H
+
+#include "staticvectorclock.h"
+#include "epoch.h"
+#include "symboltable.h"
+#include "shadowmemory.h"
+#include "parallelhandle.h"
+#include "stats.h"
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+// VectorClockState for a thread count N fixed at compile time. Same
+// interface, but each clock is a StaticVectorClock<N> held by value, so C
+// and L are each a single contiguous array of fixed-size rows. Threads can
+// still be added later, but only up to ID N - 1. Entry t always belongs to
+// thread t, so there are no slots to recycle.
+template <int N>
+class StaticVectorClockState {
+    using Clock = StaticVectorClock<N>;
+
+    std::vector<Clock> C;
+    std::vector<Clock> L;
+    std::vector<BasicReadShadow<Clock>> R;
+    std::vector<Epoch> W;
+    SymbolTable lockSymbols, locationSymbols;
+    ShadowMemory addresses;
+    ParallelHandle parallel;
+    int threads;
+public:
+    // All threads start at C[t][t] = 1, everything else at zero. Throws
+    // std::out_of_range if num_threads > N.
+    explicit StaticVectorClockState(int num_threads);
+
+    int numThreads() const;
+    int clockWidth() const;
+
+    // Make sure thread t exists; throws std::out_of_range if t >= N
+    int addThread(int index);
+
+    // ID of a lock or atomic object, creating its zero clock on first use
+    int addLock(std::string_view name);
+    // ID of an existing lock or atomic object; throws std::out_of_range otherwise
+    int lockId(std::string_view name) const;
+    // ID of a shared location, creating its shadow on first use
+    int locationId(std::string_view name);
+    // ID of the location holding address, creating it on first use. It is
+    // named after the start of its granule, e.g. "0x7ffd1000", when printed,
+    // but locationId does not find it under that name.
+    int addressId(std::uint64_t address);
+
+    // Granule size for addressId: 1, 4 or 8 bytes (default 8). Throws
+    // std::logic_error once an address has been mapped.
+    void setAddressGranularity(int bytes);
+    int addressGranularity() const;
+
+    const SymbolTable& locks() const;
+    const SymbolTable& locations() const;
+
+    void updateC(int index, const Clock& newClock);
+    void updateL(int id, const Clock& newClock);
+    void updateW(int id, const Epoch& epoch);
+
+    // C[t] := max(C[t], L[id]), in place
+    void joinLIntoC(int id, int index);
+    // L[id] := C[t], reusing L[id]'s buffer
+    void assignCToL(int index, int id);
+    void tick(int index);
+    // C[child] := max(C[child], C[parent]), then tick the parent
+    void forkThread(int parent, int child);
+    // C[parent] := max(C[parent], C[child]), then tick the child
+    void joinThread(int parent, int child);
+
+    Clock& getC(int index);
+    const Clock& getL(int id) const;
+    BasicReadShadow<Clock>& getR(int id);
+    Epoch& getW(int id);
+
+    // Read-shared clock of r, which must be isShared()
+    Clock& sharedRead(const BasicReadShadow<Clock>& r);
+    void inflate(BasicReadShadow<Clock>& r, const Epoch& e);
+    void collapse(BasicReadShadow<Clock>& r, const Epoch& e);
+
+    // Current epoch C[t][t]@t of thread t
+    Epoch epoch(int index) const;
+    int threadOf(const Epoch& e) const;
+
+    // Back to the initial clocks, keeping every declared object
+    void reset();
+
+    // Shards and workers detectParallel keeps between calls on this state
+    ParallelContext& parallelContext() { return parallel.get(); }
+
+    // Overload << operator for printing
+    friend std::ostream& operator<<(std::ostream& os, const StaticVectorClockState& vcs) {
+        os << "\nC: ";
+        for (const auto& vc : vcs.C) os << vc << ", ";
+        os << "\nL: ";
+        for (int i = 0; i < vcs.lockSymbols.size(); ++i) os << "{" << vcs.lockSymbols.name(i) << ": " << vcs.L[i] << "}, ";
+        os << "\nR: ";
+        for (int i = 0; i < vcs.locationSymbols.size(); ++i) os << "{" << vcs.locationSymbols.name(i) << ": " << vcs.R[i] << "}, ";
+        os << "\nW: ";
+        for (int i = 0; i < vcs.locationSymbols.size(); ++i) os << "{" << vcs.locationSymbols.name(i) << ": " << vcs.W[i] << "}";
+        return os;
+    }
+};
+
+// Constructor
+template <int N>
+StaticVectorClockState<N>::StaticVectorClockState(int num_threads) : threads(0) {
+    // Same check as addThread: thread N - 1 is the last one a clock can hold
+    if (num_threads > 0) {
+        addThread(num_threads - 1);
+    }
+}
+
+template <int N>
+int StaticVectorClockState<N>::numThreads() const {
+    return threads;
+}
+
+template <int N>
+int StaticVectorClockState<N>::clockWidth() const {
+    return N;
+}
+
+template <int N>
+int StaticVectorClockState<N>::addThread(int index) {
+    if (index < 0 || index >= N) {
+        throw std::out_of_range("Thread " + std::to_string(index) + " does not fit a clock of width " + std::to_string(N));
+    }
+    for (; threads <= index; ++threads) {
+        C.emplace_back();
+        C.back().increment(threads);
+    }
+    return index;
+}
+
+template <int N>
+int StaticVectorClockState<N>::addLock(std::string_view name) {
+    int id = lockSymbols.intern(name);
+    if (id >= static_cast<int>(L.size())) {
+        L.resize(id + 1);
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+    }
+    return id;
+}
+
+template <int N>
+int StaticVectorClockState<N>::lockId(std::string_view name) const {
+    int id = lockSymbols.find(name);
+    if (id < 0) {
+        throw std::out_of_range("Unknown lock or atomic object: " + std::string(name));
+    }
+    return id;
+}
+
+template <int N>
+int StaticVectorClockState<N>::locationId(std::string_view name) {
+    int id = locationSymbols.intern(name);
+    if (id >= static_cast<int>(R.size())) {
+        R.resize(id + 1);
+        W.resize(id + 1);
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+    }
+    return id;
+}
+
+template <int N>
+int StaticVectorClockState<N>::addressId(std::uint64_t address) {
+    int& cell = addresses.cell(address);
+    if (cell == 0) {
+        // Named only when printed
+        const int id = locationSymbols.addAddress(addresses.granule(address));
+        R.resize(id + 1);
+        W.resize(id + 1);
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+        cell = id + 1;
+    }
+    return cell - 1;
+}
+
+template <int N>
+void StaticVectorClockState<N>::setAddressGranularity(int bytes) {
+    if (addresses.used()) {
+        throw std::logic_error("Address granularity cannot change after addresses are mapped");
+    }
+    addresses = ShadowMemory(bytes);
+}
+
+template <int N>
+int StaticVectorClockState<N>::addressGranularity() const {
+    return addresses.granularity();
+}
+
+template <int N>
+const SymbolTable& StaticVectorClockState<N>::locks() const { return lockSymbols; }
+template <int N>
+const SymbolTable& StaticVectorClockState<N>::locations() const { return locationSymbols; }
+
+// Update a specific clock in the vector C
+template <int N>
+void StaticVectorClockState<N>::updateC(int index, const StaticVectorClock<N>& newClock) {
+    if (index >= 0 && index < static_cast<int>(C.size())) {
+        C[index] = newClock;
+    }
+}
+
+// Update the clock of a lock or atomic object
+template <int N>
+void StaticVectorClockState<N>::updateL(int id, const StaticVectorClock<N>& newClock) {
+    L[id] = newClock;
+}
+
+// Record the last write epoch of a location
+template <int N>
+void StaticVectorClockState<N>::updateW(int id, const Epoch& epoch) {
+    W[id] = epoch;
+}
+
+template <int N>
+void StaticVectorClockState<N>::joinLIntoC(int id, int index) {
+    L[id].joinInto(C.at(index));
+}
+
+template <int N>
+void StaticVectorClockState<N>::assignCToL(int index, int id) {
+    L[id].assignFrom(C.at(index));
+}
+
+template <int N>
+void StaticVectorClockState<N>::tick(int index) {
+    C.at(index).increment(index);
+}
+
+template <int N>
+void StaticVectorClockState<N>::forkThread(int parent, int child) {
+    addThread(child);
+    C.at(parent).joinInto(C[child]);
+    C[parent].increment(parent);
+}
+
+template <int N>
+void StaticVectorClockState<N>::joinThread(int parent, int child) {
+    C.at(child).joinInto(C.at(parent));
+    C[child].increment(child);
+}
+
+// Accessor methods to get references; IDs must come from addLock/locationId
+template <int N>
+StaticVectorClock<N>& StaticVectorClockState<N>::getC(int index) { return C.at(index); }
+template <int N>
+const StaticVectorClock<N>& StaticVectorClockState<N>::getL(int id) const { return L[id]; }
+template <int N>
+BasicReadShadow<StaticVectorClock<N>>& StaticVectorClockState<N>::getR(int id) { return R[id]; }
+template <int N>
+Epoch& StaticVectorClockState<N>::getW(int id) { return W[id]; }
+
+template <int N>
+Epoch StaticVectorClockState<N>::epoch(int index) const {
+    return Epoch(index, C.at(index)[index]);
+}
+
+template <int N>
+int StaticVectorClockState<N>::threadOf(const Epoch& e) const {
+    return e.thread;
+}
+
+template <int N>
+StaticVectorClock<N>& StaticVectorClockState<N>::sharedRead(const BasicReadShadow<StaticVectorClock<N>>& r) {
+    return *r.shared;
+}
+
+template <int N>
+void StaticVectorClockState<N>::inflate(BasicReadShadow<StaticVectorClock<N>>& r, const Epoch& e) {
+    r.inflate(threads, e);
+}
+
+template <int N>
+void StaticVectorClockState<N>::collapse(BasicReadShadow<StaticVectorClock<N>>& r, const Epoch& e) {
+    r.collapse(e);
+}
+
+template <int N>
+void StaticVectorClockState<N>::reset() {
+    std::fill(R.begin(), R.end(), BasicReadShadow<StaticVectorClock<N>>());
+    std::fill(W.begin(), W.end(), Epoch());
+    std::fill(L.begin(), L.end(), StaticVectorClock<N>());
+    std::fill(C.begin(), C.end(), StaticVectorClock<N>());
+    for (int i = 0; i < threads; ++i) {
+        C[i].increment(i);
+    }
+}
+
+#endif
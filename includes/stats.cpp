@@ -0,0 +1,169 @@
+#include "stats.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Every block ever handed out. When its thread exits, a block's counts are
+// folded into the retired total and the zeroed block goes on the free list
+// for the next thread, so the registry grows with the most threads counting
+// at once, not with every thread that ever counted.
+struct Registry {
+    std::vector<std::unique_ptr<StatsBlock>> blocks;
+    std::vector<StatsBlock*> free;
+    Stats retired;
+};
+
+std::mutex registryLock;
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+void clear(StatsBlock& block) {
+    for (int o = 0; o < STAT_OPCODES; ++o) {
+        block.events[o].store(0, std::memory_order_relaxed);
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            block.latency[o][b].store(0, std::memory_order_relaxed);
+        }
+    }
+    for (int c = 0; c < STAT_COUNTERS; ++c) {
+        block.counters[c].store(0, std::memory_order_relaxed);
+    }
+}
+
+void add(Stats& total, const StatsBlock& block) {
+    for (int o = 0; o < STAT_OPCODES; ++o) {
+        total.events[o] += block.events[o].load(std::memory_order_relaxed);
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            total.latency[o][b] += block.latency[o][b].load(std::memory_order_relaxed);
+        }
+    }
+    for (int c = 0; c < STAT_COUNTERS; ++c) {
+        total.counters[c] += block.counters[c].load(std::memory_order_relaxed);
+    }
+}
+
+// Retires the calling thread's block when the thread exits
+struct BlockLease {
+    StatsBlock* block = nullptr;
+    ~BlockLease() {
+        if (!block) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(registryLock);
+        add(registry().retired, *block);
+        clear(*block);
+        registry().free.push_back(block);
+        localStatsBlock = nullptr;
+    }
+};
+thread_local BlockLease lease;
+
+const char* counterName(int c) {
+    switch (static_cast<Counter>(c)) {
+    case Counter::Joins: return "joins";
+    case Counter::Copies: return "copies";
+    case Counter::Compares: return "compares";
+    case Counter::EntriesTouched: return "entries touched";
+    case Counter::ShadowInserts: return "shadow inserts";
+    }
+    return "unknown";
+}
+
+}
+
+StatsBlock& registerStatsBlock() {
+    std::lock_guard<std::mutex> guard(registryLock);
+    Registry& r = registry();
+    if (r.free.empty()) {
+        r.blocks.push_back(std::make_unique<StatsBlock>());
+        localStatsBlock = r.blocks.back().get();
+    } else {
+        localStatsBlock = r.free.back();
+        r.free.pop_back();
+    }
+    lease.block = localStatsBlock;
+    return *localStatsBlock;
+}
+
+Stats collectStats() {
+    std::lock_guard<std::mutex> guard(registryLock);
+    Stats total = registry().retired;
+    // Free blocks are zero, so they can be summed with the others
+    for (const auto& block : registry().blocks) {
+        add(total, *block);
+    }
+    return total;
+}
+
+void resetStats() {
+    std::lock_guard<std::mutex> guard(registryLock);
+    registry().retired = Stats();
+    for (const auto& block : registry().blocks) {
+        clear(*block);
+    }
+}
+
+std::uint64_t Stats::totalEvents() const {
+    std::uint64_t sum = 0;
+    for (std::uint64_t n : events) {
+        sum += n;
+    }
+    return sum;
+}
+
+std::uint64_t Stats::latencyPercentile(Opcode op, double fraction) const {
+    const std::uint64_t* buckets = latency[static_cast<int>(op)];
+    std::uint64_t samples = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+        samples += buckets[b];
+    }
+    if (samples == 0) {
+        return 0;
+    }
+    std::uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen >= fraction * samples) {
+            return std::uint64_t(1) << (b + 1);
+        }
+    }
+    return std::uint64_t(1) << LATENCY_BUCKETS;
+}
+
+std::ostream& operator<<(std::ostream& os, const Stats& stats) {
+    if (!STATS_ENABLED) {
+        return os << "stats: not compiled in (build with -DDETECTOR_STATS)" << std::endl;
+    }
+    os << "events: " << stats.totalEvents() << std::endl;
+    for (int o = 0; o < STAT_OPCODES; ++o) {
+        const Opcode op = static_cast<Opcode>(o);
+        if (stats.events[o] == 0) {
+            continue;
+        }
+        os << "  " << opcodeName(op) << ": " << stats.events[o]
+           << " (p50 < " << stats.latencyPercentile(op, 0.5) << " ns, p99 < "
+           << stats.latencyPercentile(op, 0.99) << " ns)" << std::endl;
+    }
+    for (int c = 0; c < STAT_COUNTERS; ++c) {
+        os << counterName(c) << ": " << stats.counters[c] << std::endl;
+    }
+    os << "latency samples (ns bucket: count):" << std::endl;
+    for (int o = 0; o < STAT_OPCODES; ++o) {
+        bool any = false;
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            if (stats.latency[o][b] == 0) {
+                continue;
+            }
+            os << (any ? ", " : std::string("  ") + opcodeName(static_cast<Opcode>(o)) + ": ")
+               << (b == 0 ? 0 : std::uint64_t(1) << b) << ": " << stats.latency[o][b];
+            any = true;
+        }
+        if (any) {
+            os << std::endl;
+        }
+    }
+    return os;
+}
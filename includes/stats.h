@@ -0,0 +1,133 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "event.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+// Hot-path counters, compiled in with -DDETECTOR_STATS and compiled out
+// otherwise: DETECTOR_STAT(...) then expands to nothing and StatEvent is
+// empty. Each thread counts into its own block, so counting never shares a
+// cache line or takes a lock; collectStats() sums the blocks of the running
+// threads and the totals folded in from exited ones. One event in
+// STATS_SAMPLE_PERIOD per thread is also timed into a per-opcode latency
+// histogram.
+
+#ifndef STATS_SAMPLE_PERIOD
+#define STATS_SAMPLE_PERIOD 64
+#endif
+
+#ifdef DETECTOR_STATS
+constexpr bool STATS_ENABLED = true;
+#define DETECTOR_STAT(statement) do { statement; } while (0)
+#else
+constexpr bool STATS_ENABLED = false;
+#define DETECTOR_STAT(statement) do {} while (0)
+#endif
+
+enum class Counter {
+    Joins,           // clock joins
+    Copies,          // clock copies (assignFrom)
+    Compares,        // clock comparisons (<= and findGreater)
+    EntriesTouched,  // clock entries read or written by the above
+    ShadowInserts,   // new lock and location shadows
+};
+
+constexpr int STAT_COUNTERS = 5;
+constexpr int STAT_OPCODES = 9;
+// Bucket b holds latencies in [2^b, 2^(b+1)) ns; bucket 0 also holds 0 ns
+constexpr int LATENCY_BUCKETS = 32;
+
+// Totals over all threads
+struct Stats {
+    std::uint64_t events[STAT_OPCODES] = {};
+    std::uint64_t counters[STAT_COUNTERS] = {};
+    std::uint64_t latency[STAT_OPCODES][LATENCY_BUCKETS] = {};
+
+    std::uint64_t operator[](Counter c) const { return counters[static_cast<int>(c)]; }
+    std::uint64_t operator[](Opcode op) const { return events[static_cast<int>(op)]; }
+    std::uint64_t totalEvents() const;
+    // Upper bound of the bucket holding the given fraction of op's samples
+    std::uint64_t latencyPercentile(Opcode op, double fraction) const;
+};
+
+// Dump of all non-zero counters and histograms
+std::ostream& operator<<(std::ostream& os, const Stats& stats);
+
+// Safe while other threads are counting; their latest increments may be missed
+Stats collectStats();
+// Zero every block; only call while no analysis is running
+void resetStats();
+
+// One thread's counters. Only the owner writes, so a relaxed load and store
+// is enough to keep concurrent readers race-free.
+struct StatsBlock {
+    std::atomic<std::uint64_t> events[STAT_OPCODES] = {};
+    std::atomic<std::uint64_t> counters[STAT_COUNTERS] = {};
+    std::atomic<std::uint64_t> latency[STAT_OPCODES][LATENCY_BUCKETS] = {};
+    unsigned tick = 0;   // owner only: events until the next sample
+};
+
+StatsBlock& registerStatsBlock();
+
+inline thread_local StatsBlock* localStatsBlock = nullptr;
+
+inline StatsBlock& localStats() {
+    StatsBlock* block = localStatsBlock;
+    return block ? *block : registerStatsBlock();
+}
+
+inline void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void countStat(Counter c, std::uint64_t n = 1) {
+    bump(localStats().counters[static_cast<int>(c)], n);
+}
+
+// A clock operation of the given kind over width entries
+inline void countClockOp(Counter c, std::uint64_t width) {
+    StatsBlock& block = localStats();
+    bump(block.counters[static_cast<int>(c)]);
+    bump(block.counters[static_cast<int>(Counter::EntriesTouched)], width);
+}
+
+#ifdef DETECTOR_STATS
+// Counts one event for its lifetime and times it if it is sampled
+class StatEvent {
+    StatsBlock& block;
+    Opcode op;
+    bool timed;
+    std::chrono::steady_clock::time_point start;
+public:
+    explicit StatEvent(Opcode op) : block(localStats()), op(op), timed(block.tick == 0) {
+        block.tick = timed ? STATS_SAMPLE_PERIOD - 1 : block.tick - 1;
+        if (timed) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~StatEvent() {
+        const int o = static_cast<int>(op);
+        bump(block.events[o]);
+        if (timed) {
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            int bucket = 0;
+            while (bucket + 1 < LATENCY_BUCKETS && (std::uint64_t(1) << (bucket + 1)) <= std::uint64_t(ns)) {
+                ++bucket;
+            }
+            bump(block.latency[o][bucket]);
+        }
+    }
+    StatEvent(const StatEvent&) = delete;
+    StatEvent& operator=(const StatEvent&) = delete;
+};
+#else
+struct StatEvent {
+    explicit StatEvent(Opcode) {}
+};
+#endif
+
+#endif
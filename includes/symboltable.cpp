@@ -0,0 +1,87 @@
+#include "symboltable.h"
+#include "shadowmemory.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static std::uint32_t hashName(std::string_view name) {
+    std::uint64_t h = std::hash<std::string_view>()(name);
+    return static_cast<std::uint32_t>(h ^ (h >> 32));
+}
+
+// Slot holding name, or the empty slot where it would go
+std::size_t SymbolTable::probe(std::string_view name, std::uint32_t hash) const {
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (slot.id < 0 || (slot.hash == hash && names[slot.id] == name)) {
+            return i;
+        }
+    }
+}
+
+// Double the table, keeping the load factor at or below 3/4
+void SymbolTable::grow() {
+    std::vector<Slot> old(slots.size() ? slots.size() * 2 : 16);
+    old.swap(slots);
+    const std::size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.id < 0) {
+            continue;
+        }
+        std::size_t i = slot.hash & mask;
+        while (slots[i].id >= 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
+}
+
+int SymbolTable::intern(std::string_view name) {
+    if ((names.size() + 1) * 4 > slots.size() * 3) {
+        grow();
+    }
+    const std::uint32_t hash = hashName(name);
+    Slot& slot = slots[probe(name, hash)];
+    if (slot.id < 0) {
+        slot.hash = hash;
+        slot.id = static_cast<int>(names.size());
+        names.emplace_back(name);
+        if (!addresses.empty()) {
+            addresses.push_back(NO_ADDRESS);
+        }
+    }
+    return slot.id;
+}
+
+int SymbolTable::addAddress(std::uint64_t address) {
+    addresses.resize(names.size(), NO_ADDRESS);
+    addresses.push_back(address);
+    names.emplace_back();
+    return static_cast<int>(names.size()) - 1;
+}
+
+bool SymbolTable::isAddress(int id) const {
+    return id >= 0 && static_cast<std::size_t>(id) < addresses.size() && addresses[id] != NO_ADDRESS;
+}
+
+std::uint64_t SymbolTable::address(int id) const {
+    return addresses.at(id);
+}
+
+int SymbolTable::find(std::string_view name) const {
+    if (slots.empty()) {
+        return -1;
+    }
+    return slots[probe(name, hashName(name))].id;
+}
+
+std::string SymbolTable::name(int id) const {
+    return isAddress(id) ? addressName(addresses[id]) : names.at(id);
+}
+
+int SymbolTable::size() const {
+    return static_cast<int>(names.size());
+}
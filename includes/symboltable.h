@@ -0,0 +1,52 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <string>
+#include <string_view>
+
+// Maps object names (locations, locks, atomics) to dense integer IDs so the
+// shadow state can be kept in flat arrays instead of string-keyed maps.
+// Lookups take a string_view and only allocate when a new name is added.
+//
+// The index is an open-addressing table with linear probing. Each slot holds
+// just the name's hash and its ID, so a probe sequence scans adjacent 8-byte
+// slots and only touches the string itself when the hashes match.
+//
+// Locations found by address (see ShadowMemory) are added with addAddress
+// instead. They keep just the address, and get their "0x..." name from
+// name() when it is needed for printing, so the first access to a granule
+// does not format or hash a string. find() and intern() do not see them.
+class SymbolTable {
+    struct Slot {
+        std::uint32_t hash = 0;
+        int id = -1;    // -1 marks an empty slot
+    };
+
+    static constexpr std::uint64_t NO_ADDRESS = ~std::uint64_t(0);
+
+    std::vector<Slot> slots;    // size is zero or a power of two
+    std::deque<std::string> names;      // empty for address entries
+    std::vector<std::uint64_t> addresses;   // by ID once any address was added
+
+    std::size_t probe(std::string_view name, std::uint32_t hash) const;
+    void grow();
+public:
+    // Return the ID of name, assigning the next free one on first use
+    int intern(std::string_view name);
+
+    // Return the ID of name, or -1 if it was never interned
+    int find(std::string_view name) const;
+
+    // Add an entry for the location at address; always a new ID
+    int addAddress(std::uint64_t address);
+    bool isAddress(int id) const;
+    std::uint64_t address(int id) const;
+
+    std::string name(int id) const;
+    int size() const;
+};
+
+#endif
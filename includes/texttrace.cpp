@@ -0,0 +1,98 @@
+#include "texttrace.h"
+#include "run.h"
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return s;
+}
+
+static bool parseThread(std::string_view text, std::uint32_t& thread) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), thread);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+static bool parseOpcode(std::string_view name, Opcode& op) {
+    static constexpr Opcode ops[] = {Opcode::Read, Opcode::Write, Opcode::Acquire, Opcode::Release,
+                                     Opcode::AtomicLoad, Opcode::AtomicStore, Opcode::AtomicRMW,
+                                     Opcode::Fork, Opcode::Join};
+    for (Opcode candidate : ops) {
+        if (name == opcodeName(candidate)) {
+            op = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+TextTraceReader::TextTraceReader(std::istream& in) : in(in) {}
+
+TextTraceReader::Parsed TextTraceReader::parse(std::string_view text) const {
+    auto fail = [&](const char* why) {
+        throw std::runtime_error("Trace line " + std::to_string(lineNumber) + ": " + why);
+    };
+
+    // Op(thread, name)
+    std::size_t open = text.find('(');
+    std::size_t comma = text.find(',', open);
+    if (open == std::string_view::npos || comma == std::string_view::npos || text.back() != ')') {
+        fail("expected Op(thread, name)");
+    }
+
+    Opcode op;
+    if (!parseOpcode(trim(text.substr(0, open)), op)) {
+        fail("unknown instruction");
+    }
+
+    std::string_view tid = trim(text.substr(open + 1, comma - open - 1));
+    std::uint32_t thread = 0;
+    if (!parseThread(tid, thread)) {
+        fail("bad thread id");
+    }
+    if (thread >= TEXT_TRACE_MAX_THREADS) {
+        fail("thread id out of range");
+    }
+
+    std::string_view name = trim(text.substr(comma + 1, text.size() - comma - 2));
+    if (name.empty()) {
+        fail("missing name");
+    }
+
+    std::uint32_t child = 0;
+    if (isThreadOp(op) && !parseThread(name, child)) {
+        fail("bad child thread id");
+    }
+    if (child >= TEXT_TRACE_MAX_THREADS) {
+        fail("child thread id out of range");
+    }
+
+    bool addressed = isAccess(op) && name.size() > 2 && name[0] == '0' && (name[1] == 'x' || name[1] == 'X');
+    std::uint64_t address = 0;
+    if (addressed) {
+        auto [end, error] = std::from_chars(name.data() + 2, name.data() + name.size(), address, 16);
+        if (error != std::errc() || end != name.data() + name.size()) {
+            fail("bad address");
+        }
+    }
+
+    return Parsed{op, thread, name, child, addressed, address};
+}
+
+bool TextTraceReader::nextLine(Parsed& parsed) {
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::string_view text = trim(line);
+        if (text.empty() || text.front() == '#') {
+            continue;
+        }
+        parsed = parse(text);
+        return true;
+    }
+    return false;
+}
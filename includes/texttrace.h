@@ -0,0 +1,105 @@
+#ifndef TEXTTRACE_H
+#define TEXTTRACE_H
+
+#include "event.h"
+#include "run.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Most threads a text trace may use. Every ID up to the highest one seen gets
+// a clock, so larger IDs are rejected like TRACE_MAX_THREADS in binary traces.
+constexpr std::uint32_t TEXT_TRACE_MAX_THREADS = 1 << 16;
+
+// Streaming reader for line-oriented text traces in Instruction::toString()
+// syntax, one event per line:
+//
+//   Fork(0, 1)
+//   Acquire(1, m)
+//   Write(1, x)
+//   Read(1, 0x7ffd1000)
+//   Release(1, m)
+//   Join(0, 1)
+//
+// Blank lines and lines starting with '#' are skipped. Names are interned
+// into the state as they are first seen; a lock or atomic object that has
+// not been released yet starts with the zero clock, and threads are added on
+// first appearance. The line buffer is
+// reused, so parsing a line only allocates when it introduces a new name.
+class TextTraceReader {
+    std::istream& in;
+    std::string line;
+    std::size_t lineNumber = 0;
+
+    // One decoded line; name views into the line buffer until the next read.
+    // For Fork and Join, child holds the second thread instead of a name; a
+    // Read or Write of a "0x..." name is an access to that address.
+    struct Parsed {
+        Opcode op;
+        std::uint32_t thread;
+        std::string_view name;
+        std::uint32_t child;
+        bool addressed;
+        std::uint64_t address;
+    };
+
+    bool nextLine(Parsed& parsed);
+    Parsed parse(std::string_view text) const;
+public:
+    explicit TextTraceReader(std::istream& in);
+
+    // Decode the next event into ev, interning its name into target (a
+    // VectorClockState or a Detector); returns false at end of input.
+    // Throws std::runtime_error on a malformed line.
+    template <typename Target>
+    bool next(Target& target, Event& ev) {
+        Parsed parsed;
+        if (!nextLine(parsed)) {
+            return false;
+        }
+        target.addThread(static_cast<int>(parsed.thread));
+        int id;
+        if (isThreadOp(parsed.op)) {
+            id = target.addThread(static_cast<int>(parsed.child));
+        } else if (parsed.addressed) {
+            id = target.addressId(parsed.address);
+        } else {
+            id = isAccess(parsed.op) ? target.locationId(parsed.name) : target.addLock(parsed.name);
+        }
+        ev = Event{parsed.op, parsed.thread, static_cast<std::uint64_t>(id)};
+        return true;
+    }
+
+    // Decode up to max events into batch (cleared first); returns false once
+    // the input is exhausted and nothing was read.
+    template <typename Target>
+    bool nextBatch(Target& target, std::vector<Event>& batch, std::size_t max) {
+        batch.clear();
+        Event ev;
+        while (batch.size() < max && next(target, ev)) {
+            batch.push_back(ev);
+        }
+        return !batch.empty();
+    }
+};
+
+constexpr std::size_t TEXT_TRACE_BATCH_SIZE = 4096;
+
+// Feed a text trace through the detector in fixed-size batches. Memory stays
+// proportional to the shadow state, not to the length of the trace.
+template <typename Target>
+RunResult runTextTrace(Target& target, std::istream& in, const RunOptions& options = RunOptions()) {
+    TextTraceReader reader(in);
+    RunResult result;
+    std::vector<Event> batch;
+    batch.reserve(TEXT_TRACE_BATCH_SIZE);
+    while (!result.stopped && reader.nextBatch(target, batch, TEXT_TRACE_BATCH_SIZE)) {
+        detect(target, batch.data(), batch.data() + batch.size(), options, result);
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,44 @@
+#include "threadslots.h"
+#include <algorithm>
+#include <vector>
+
+void ThreadSlots::declare(int index) {
+    if (index >= threads()) {
+        slotOf.resize(index + 1, -1);
+    }
+}
+
+Epoch ThreadSlots::take(int index, const Epoch& e) {
+    if (e.thread == slots()) {
+        owners.emplace_back();
+    }
+    owners[e.thread].push_back(Owner{e.clock, index});
+    slotOf[index] = e.thread;
+    return e;
+}
+
+void ThreadSlots::retire(int index, int last) {
+    retired.push_back(Retired{slotOf[index], last});
+    slotOf[index] = -1;
+}
+
+int ThreadSlots::threadOf(const Epoch& e) const {
+    if (e.thread >= slots()) {
+        return e.thread;
+    }
+    const std::vector<Owner>& list = owners[e.thread];
+    // Last owner that started at or before e.clock; the bottom epoch 0@u
+    // goes to the first
+    auto it = std::upper_bound(list.begin(), list.end(), e.clock,
+                               [](int clock, const Owner& o) { return clock < o.start; });
+    return it == list.begin() ? list.front().thread : std::prev(it)->thread;
+}
+
+void ThreadSlots::reset(int num_threads) {
+    std::fill(slotOf.begin(), slotOf.end(), -1);
+    owners.clear();
+    retired.clear();
+    for (int t = 0; t < num_threads; ++t) {
+        take(t, Epoch(t, 1));
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef THREADSLOTS_H
+#define THREADSLOTS_H
+
+#include "epoch.h"
+#include <iterator>
+#include <vector>
+
+// Assignment of clock entries (slots) to thread IDs. A thread takes a slot
+// when it first acts or is forked and gives it back when it is joined, so
+// clocks are as wide as the number of threads alive at once rather than the
+// highest thread ID.
+//
+// A freed slot is only handed to a thread whose clock already covers every
+// event of its previous owner, and the new owner counts on from above the
+// old one's last value. The slot then behaves like one thread running its
+// owners one after the other, an order the join and fork between them
+// already imply, so clock comparisons stay exact. Epochs name slots;
+// threadOf() maps one back to the thread whose event it was.
+class ThreadSlots {
+    struct Owner {
+        int start;     // first own entry of thread on the slot
+        int thread;
+    };
+    struct Retired {
+        int slot;
+        int last;      // the slot's entry in its owner's clock after the join
+    };
+
+    std::vector<int> slotOf;                  // per thread, -1 while it has none
+    std::vector<std::vector<Owner>> owners;   // per slot, in order of start
+    std::vector<Retired> retired;
+
+    Epoch take(int index, const Epoch& e);
+public:
+    int threads() const { return static_cast<int>(slotOf.size()); }
+    // Slots handed out so far; clocks need at least this many entries
+    int slots() const { return static_cast<int>(owners.size()); }
+
+    // Make sure thread t is known, without giving it a slot
+    void declare(int index);
+    bool active(int index) const { return slotOf[index] >= 0; }
+    int slot(int index) const { return slotOf[index]; }
+
+    // Give thread t a slot, given its current clock: a freed slot the clock
+    // has seen finish, or else a new one. Returns the slot and t's first own
+    // entry on it, which the caller writes into t's clock.
+    template <typename Clock>
+    Epoch activate(int index, const Clock& clock) {
+        // The most recently freed slots are the likeliest to be known
+        for (auto it = retired.rbegin(); it != retired.rend(); ++it) {
+            if (clock[it->slot] + 1 >= it->last) {
+                const Epoch e(it->slot, it->last + 1);
+                retired.erase(std::next(it).base());
+                return take(index, e);
+            }
+        }
+        return take(index, Epoch(slots(), 1));
+    }
+
+    // Free thread t's slot once it has been joined; last is t's own entry
+    void retire(int index, int last);
+
+    // Thread that made the event at epoch e
+    int threadOf(const Epoch& e) const;
+
+    // Threads 0..n-1 back on slots 0..n-1, all others without one
+    void reset(int num_threads);
+};
+
+#endif
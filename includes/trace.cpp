@@ -0,0 +1,195 @@
+#include "trace.h"
+#include "run.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void writeName(std::ofstream& out, const std::string& name) {
+    std::uint32_t length = static_cast<std::uint32_t>(name.size());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(name.data(), length);
+}
+
+void writeTrace(const std::string& path, const VectorClockState& state, const std::vector<Event>& events) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not open trace for writing: " + path);
+    }
+
+    TraceHeader header{};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.num_threads = static_cast<std::uint32_t>(state.numThreads());
+    header.num_locks = static_cast<std::uint32_t>(state.locks().size());
+    header.num_locations = static_cast<std::uint32_t>(state.locations().size());
+    header.num_events = events.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (int i = 0; i < state.locks().size(); ++i) writeName(out, state.locks().name(i));
+    for (int i = 0; i < state.locations().size(); ++i) writeName(out, state.locations().name(i));
+
+    // Pad so the event records can be used in place from the mapping
+    std::uint64_t offset = static_cast<std::uint64_t>(out.tellp());
+    std::uint64_t aligned = (offset + alignof(Event) - 1) / alignof(Event) * alignof(Event);
+    for (; offset < aligned; ++offset) out.put('\0');
+
+    // Copy the records field by field into a zeroed buffer, so that the
+    // padding after op is written as zeros rather than whatever was in memory
+    constexpr std::size_t CHUNK = 4096;
+    std::vector<char> buffer;
+    for (std::size_t first = 0; first < events.size(); first += CHUNK) {
+        const std::size_t count = std::min(CHUNK, events.size() - first);
+        buffer.assign(count * sizeof(Event), '\0');
+        for (std::size_t i = 0; i < count; ++i) {
+            const Event& ev = events[first + i];
+            char* record = buffer.data() + i * sizeof(Event);
+            std::memcpy(record + offsetof(Event, op), &ev.op, sizeof(ev.op));
+            std::memcpy(record + offsetof(Event, thread), &ev.thread, sizeof(ev.thread));
+            std::memcpy(record + offsetof(Event, object), &ev.object, sizeof(ev.object));
+        }
+        out.write(buffer.data(), buffer.size());
+    }
+
+    // Patch the events offset in now that the symbol table size is known
+    header.events_offset = aligned;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out) {
+        throw std::runtime_error("Failed writing trace: " + path);
+    }
+}
+
+MappedTrace::MappedTrace(const std::string& path) : path(path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open trace: " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(TraceHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Trace too short: " + path);
+    }
+    length = static_cast<std::size_t>(st.st_size);
+    base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        throw std::runtime_error("Could not map trace: " + path);
+    }
+    // Events are consumed front to back exactly once
+    ::madvise(base, length, MADV_SEQUENTIAL);
+
+    const char* bytes = static_cast<const char*>(base);
+    header = reinterpret_cast<const TraceHeader*>(bytes);
+
+    auto fail = [&](const std::string& why) {
+        ::munmap(base, length);
+        base = nullptr;
+        throw std::runtime_error("Malformed trace " + path + ": " + why);
+    };
+    if (std::memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) fail("bad magic");
+    if (header->version != TRACE_VERSION) fail("unsupported version " + std::to_string(header->version));
+    if (header->num_threads > TRACE_MAX_THREADS) fail("too many threads " + std::to_string(header->num_threads));
+    if (header->events_offset % alignof(Event) != 0 || header->events_offset > length ||
+        header->num_events > (length - header->events_offset) / sizeof(Event)) {
+        fail("event section out of bounds");
+    }
+
+    std::size_t pos = sizeof(TraceHeader);
+    auto readName = [&]() {
+        std::uint32_t n;
+        if (pos + sizeof(n) > header->events_offset) fail("symbol table out of bounds");
+        std::memcpy(&n, bytes + pos, sizeof(n));
+        pos += sizeof(n);
+        if (n > header->events_offset - pos) fail("symbol table out of bounds");
+        std::string name(bytes + pos, n);
+        pos += n;
+        return name;
+    };
+    // IDs are positions in the table, so a repeated name would intern to
+    // fewer objects than the events index
+    auto readNames = [&](std::uint32_t count, std::vector<std::string>& names, const char* kind) {
+        names.reserve(count);
+        std::unordered_set<std::string> seen;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            names.push_back(readName());
+            if (!seen.insert(names.back()).second) fail(std::string("duplicate ") + kind + " name " + names.back());
+        }
+    };
+    readNames(header->num_locks, lockNames, "lock");
+    readNames(header->num_locations, locationNames, "location");
+}
+
+void MappedTrace::check(std::size_t first, std::size_t last, std::uint64_t& threads) const {
+    // The engine indexes its tables with the event fields unchecked. A
+    // thread must have been declared in the header or forked by an earlier
+    // event before it appears.
+    const Event* events = begin();
+    for (std::size_t i = first; i < last; ++i) {
+        const Event& ev = events[i];
+        auto bad = [&](const std::string& why) {
+            throw std::runtime_error("Malformed trace " + path + ": event " + std::to_string(i) + ": " + why);
+        };
+        if (ev.op > Opcode::Join) bad("unknown opcode " + std::to_string(static_cast<int>(ev.op)));
+        if (ev.thread >= threads) bad("unknown thread " + std::to_string(ev.thread));
+        if (isAccess(ev.op)) {
+            if (ev.object >= header->num_locations) bad("location " + std::to_string(ev.object) + " out of range");
+        } else if (ev.op == Opcode::Fork) {
+            if (ev.object >= TRACE_MAX_THREADS) bad("child thread " + std::to_string(ev.object) + " out of range");
+            threads = std::max(threads, ev.object + 1);
+        } else if (ev.op == Opcode::Join) {
+            if (ev.object >= threads) bad("unknown child thread " + std::to_string(ev.object));
+        } else if (ev.object >= header->num_locks) {
+            bad("lock " + std::to_string(ev.object) + " out of range");
+        }
+    }
+}
+
+MappedTrace::~MappedTrace() {
+    if (base) {
+        ::munmap(base, length);
+    }
+}
+
+int MappedTrace::numThreads() const { return static_cast<int>(header->num_threads); }
+const std::vector<std::string>& MappedTrace::locks() const { return lockNames; }
+const std::vector<std::string>& MappedTrace::locations() const { return locationNames; }
+
+std::size_t MappedTrace::size() const { return static_cast<std::size_t>(header->num_events); }
+
+const Event* MappedTrace::begin() const {
+    return reinterpret_cast<const Event*>(static_cast<const char*>(base) + header->events_offset);
+}
+
+const Event* MappedTrace::end() const { return begin() + size(); }
+
+VectorClockState initialVectorClockState(const MappedTrace& trace) {
+    // Interning in table order reproduces the IDs the events were written with
+    return initialVectorClockState(trace.numThreads(), trace.locks(), {}, trace.locations());
+}
+
+RunResult run(VectorClockState& state, const MappedTrace& trace, const RunOptions& options) {
+    if (state.locks().size() < static_cast<int>(trace.locks().size()) ||
+        state.locations().size() < static_cast<int>(trace.locations().size())) {
+        throw std::invalid_argument("State does not declare every lock and location of the trace");
+    }
+    RunResult result;
+    std::uint64_t threads = static_cast<std::uint64_t>(trace.numThreads());
+    for (std::size_t first = 0; first < trace.size() && !result.stopped; first += TRACE_CHUNK_EVENTS) {
+        // Check the chunk while it is faulted in, then analyse it from cache
+        const std::size_t last = std::min(trace.size(), first + TRACE_CHUNK_EVENTS);
+        trace.check(first, last, threads);
+        detect(state, trace.begin() + first, trace.begin() + last, options, result);
+    }
+    return result;
+}
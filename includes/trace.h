@@ -0,0 +1,88 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "detect.h"
+#include "event.h"
+#include "vectorclockstate.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// On-disk binary trace layout (native byte order):
+//
+//   TraceHeader
+//   symbol table: num_locks lock names, then num_locations location names,
+//                 each as a uint32 length followed by the bytes
+//   padding up to events_offset (a multiple of alignof(Event))
+//   num_events fixed-size Event records
+//
+// Lock and location IDs in the events are the positions of the names in the
+// symbol table, so a state built from the trace resolves them unchanged.
+struct TraceHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t num_threads;
+    std::uint32_t num_locks;
+    std::uint32_t num_locations;
+    std::uint64_t events_offset;
+    std::uint64_t num_events;
+};
+
+constexpr char TRACE_MAGIC[8] = {'D', 'R', 'D', 'T', 'R', 'A', 'C', 'E'};
+constexpr std::uint32_t TRACE_VERSION = 1;
+// Most threads a trace may declare or fork
+constexpr std::uint32_t TRACE_MAX_THREADS = 1 << 16;
+
+// Write events to path, taking the symbol table from the state they were lowered into
+void writeTrace(const std::string& path, const VectorClockState& state, const std::vector<Event>& events);
+
+// Read-only memory mapping of a binary trace. Events are read in place from
+// the mapping; only the symbol table is decoded. Throws std::runtime_error
+// if the file cannot be mapped, or if its header or symbol table is
+// malformed, including a lock or location name that appears twice.
+//
+// Event records are not read up front, since that would fault in the whole
+// file before the run starts. check() validates a range of them: known
+// opcode, object within the lock, location or thread range its opcode calls
+// for, and a thread that was declared or forked earlier. run(state, trace)
+// checks each chunk just before analysing it; code that walks begin() to
+// end() itself must call check() first.
+class MappedTrace {
+    std::string path;
+    void* base = nullptr;
+    std::size_t length = 0;
+    const TraceHeader* header = nullptr;
+    std::vector<std::string> lockNames, locationNames;
+public:
+    explicit MappedTrace(const std::string& path);
+    ~MappedTrace();
+    MappedTrace(const MappedTrace&) = delete;
+    MappedTrace& operator=(const MappedTrace&) = delete;
+
+    int numThreads() const;
+    const std::vector<std::string>& locks() const;
+    const std::vector<std::string>& locations() const;
+
+    std::size_t size() const;
+    const Event* begin() const;
+    const Event* end() const;
+
+    // Validate events [first, last). threads is the number of threads known
+    // before first (numThreads() at the start of the trace) and is raised by
+    // the forks in the range. Throws std::runtime_error on a bad record.
+    void check(std::size_t first, std::size_t last, std::uint64_t& threads) const;
+};
+
+// Events run(state, trace) checks and analyses at a time
+constexpr std::size_t TRACE_CHUNK_EVENTS = std::size_t(1) << 16;
+
+// Fresh state whose lock and location IDs match those used by trace
+VectorClockState initialVectorClockState(const MappedTrace& trace);
+
+// Check and analyse trace chunk by chunk, so the mapping is read once.
+// Throws std::invalid_argument if state has fewer locks or locations than
+// the trace names, and std::runtime_error on a malformed event.
+RunResult run(VectorClockState& state, const MappedTrace& trace, const RunOptions& options = RunOptions());
+
+#endif
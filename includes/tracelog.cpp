@@ -0,0 +1,37 @@
+#include "tracelog.h"
+#include <charconv>
+
+TraceLog::TraceLog(std::ostream& out, std::size_t snapshotEvery, std::size_t bufferSize)
+    : out(out), snapshotEvery(snapshotEvery), bufferSize(bufferSize) {
+    buffer.reserve(bufferSize + 256);
+}
+
+TraceLog::~TraceLog() {
+    flush();
+}
+
+void TraceLog::flush() {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    buffer.clear();
+}
+
+void TraceLog::put(long long n) {
+    char digits[24];
+    const auto end = std::to_chars(digits, digits + sizeof(digits), n).ptr;
+    buffer.append(digits, end);
+}
+
+void TraceLog::put(const Epoch& e) {
+    put(static_cast<long long>(e.clock));
+    put('@');
+    put(static_cast<long long>(e.thread));
+}
+
+void TraceLog::endRecord() {
+    put('\n');
+    if (buffer.size() >= bufferSize) {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+}
@@ -0,0 +1,207 @@
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include "event.h"
+#include "epoch.h"
+#include "race.h"
+#include "symboltable.h"
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Structured verbose log. Where RunOptions::verbose prints the whole state
+// after every event, a TraceLog writes one line per event with only the
+// shadow entries it changed:
+//
+//   3 Acquire(1, m) C[1][0]=2
+//   4 Write(1, x) W[x]=1@1
+//   5 Read(2, x) R[x]=[1, 0, 1]
+//   6 Read(0, x) R[x][0]=2
+//   7 Release(1, m) L[m][1]=1 C[1][1]=2
+//   9 ! WriteWriteRace(1, 2, x)
+//
+// The leading number is the event's position in the run. A read-shared
+// R[x] is written out in full when it is inflated, and only the reader's
+// entry after that. Events that change nothing (same-epoch accesses) are
+// not logged.
+// Clock entries are indexed by slot (see threadslots.h), but epochs are
+// written with the thread that made them.
+// With snapshotEvery = N, the full state follows every Nth event as a
+// "# snapshot after <position>" line and the state's usual dump.
+//
+// Output is buffered and written in blocks of about bufferSize bytes, and
+// on flush() or destruction.
+class TraceLog {
+    std::ostream& out;
+    std::size_t snapshotEvery;
+    std::size_t bufferSize;
+    std::string buffer;
+
+    // What the current event may change, as it was before the event
+    std::vector<int> first, second;
+    Epoch readEpoch, writeEpoch;
+    bool readShared = false;
+
+    void put(char c) { buffer.push_back(c); }
+    void put(const std::string& s) { buffer.append(s); }
+    void put(const char* s) { buffer.append(s); }
+    void put(long long n);
+    void put(const Epoch& e);
+    void endRecord();
+
+    template <typename State>
+    void put(const State& state, const Epoch& e) { put(Epoch(state.threadOf(e), e.clock)); }
+
+    template <typename Clock>
+    static void save(std::vector<int>& saved, const Clock& clock, int width) {
+        saved.resize(width);
+        for (int u = 0; u < width; ++u) {
+            saved[u] = clock[u];
+        }
+    }
+
+    // " <name>[u]=v" for each entry of clock that differs from saved
+    template <typename Clock>
+    void diff(const char* table, const std::string& name, const std::vector<int>& saved, const Clock& clock) {
+        for (std::size_t u = 0; u < saved.size(); ++u) {
+            if (clock[u] != saved[u]) {
+                put(' ');
+                put(table);
+                put('[');
+                put(name);
+                put("][");
+                put(static_cast<long long>(u));
+                put("]=");
+                put(static_cast<long long>(clock[u]));
+            }
+        }
+    }
+
+    template <typename State>
+    void event(const State& state, const Event& ev, std::size_t position) {
+        put(static_cast<long long>(position));
+        put(' ');
+        put(opcodeName(ev.op));
+        put('(');
+        put(static_cast<long long>(ev.thread));
+        put(", ");
+        if (isThreadOp(ev.op)) {
+            put(static_cast<long long>(ev.object));
+        } else {
+            put((isAccess(ev.op) ? state.locations() : state.locks()).name(static_cast<int>(ev.object)));
+        }
+        put(')');
+    }
+
+public:
+    explicit TraceLog(std::ostream& out, std::size_t snapshotEvery = 0, std::size_t bufferSize = 1 << 16);
+    ~TraceLog();
+
+    TraceLog(const TraceLog&) = delete;
+    TraceLog& operator=(const TraceLog&) = delete;
+
+    void flush();
+
+    // Called by the engine around each event: before() saves what ev may
+    // change, after() logs the differences once ev has been applied. Events
+    // that stopped the run or changed nothing get no after().
+    template <typename State>
+    void before(State& state, const Event& ev) {
+        const int t = static_cast<int>(ev.thread);
+        const int id = static_cast<int>(ev.object);
+        if (isAccess(ev.op)) {
+            auto& r = state.getR(id);
+            readShared = r.isShared();
+            readEpoch = r.epoch;
+            writeEpoch = state.getW(id);
+            return;
+        }
+        // Fork may widen the clocks; entries past the old width start at zero
+        const int width = state.clockWidth();
+        save(first, state.getC(t), width);
+        if (isThreadOp(ev.op)) {
+            second.assign(width, 0);
+            if (id < state.numThreads()) {
+                save(second, state.getC(id), width);
+            }
+        } else {
+            save(second, state.getL(id), width);
+        }
+    }
+
+    template <typename State>
+    void after(State& state, const Event& ev, std::size_t position) {
+        const int t = static_cast<int>(ev.thread);
+        const int id = static_cast<int>(ev.object);
+        event(state, ev, position);
+        if (isAccess(ev.op)) {
+            const std::string& x = state.locations().name(id);
+            auto& r = state.getR(id);
+            if (r.isShared()) {
+                auto&& clock = state.sharedRead(r);
+                put(" R[");
+                put(x);
+                if (readShared) {
+                    const int slot = state.epoch(t).thread;
+                    put("][");
+                    put(static_cast<long long>(slot));
+                    put("]=");
+                    put(static_cast<long long>(clock[slot]));
+                } else {
+                    put("]=[");
+                    for (int u = 0; u < state.clockWidth(); ++u) {
+                        put(u ? ", " : "");
+                        put(static_cast<long long>(clock[u]));
+                    }
+                    put(']');
+                }
+            } else if (readShared || !(r.epoch == readEpoch)) {
+                put(" R[");
+                put(x);
+                put("]=");
+                put(state, r.epoch);
+            }
+            if (!(state.getW(id) == writeEpoch)) {
+                put(" W[");
+                put(x);
+                put("]=");
+                put(state, state.getW(id));
+            }
+        } else {
+            const int width = state.clockWidth();
+            first.resize(width, 0);
+            second.resize(width, 0);
+            if (isThreadOp(ev.op)) {
+                const std::string child = std::to_string(id);
+                diff("C", child, second, state.getC(id));
+            } else {
+                diff("L", state.locks().name(id), second, state.getL(id));
+            }
+            diff("C", std::to_string(t), first, state.getC(t));
+        }
+        endRecord();
+    }
+
+    // Called after every event that did not stop the run
+    template <typename State>
+    void snapshot(const State& state, std::size_t position) {
+        if (snapshotEvery > 0 && (position + 1) % snapshotEvery == 0) {
+            std::ostringstream dump;
+            dump << "# snapshot after " << position << state;
+            put(dump.str());
+            endRecord();
+        }
+    }
+
+    template <typename State>
+    void race(const State& state, const Race& r, std::size_t position) {
+        put(static_cast<long long>(position));
+        put(" ! ");
+        put(r.toString(state.locations()));
+        endRecord();
+    }
+};
+
+#endif
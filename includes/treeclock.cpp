@@ -0,0 +1,172 @@
+#include "treeclock.h"
+#include "stats.h"
+#include "vectorclock.h"
+#include <cassert>
+#include <vector>
+
+// Nodes to update during a join or copy, children before their parent.
+// Shared by all clocks of a thread so joins never allocate.
+static std::vector<int>& scratch() {
+    thread_local std::vector<int> updated;
+    updated.clear();
+    return updated;
+}
+
+TreeClock::TreeClock(int num_threads) : values(num_threads), nodes(num_threads) {}
+
+void TreeClock::resize(int num_threads) {
+    if (num_threads <= size()) {
+        return;
+    }
+    values.resize(num_threads);
+    nodes.resize(num_threads);
+}
+
+TreeClock& TreeClock::increment(int index) {
+    if (rootThread < 0) {
+        rootThread = index;
+    }
+    assert(index == rootThread);
+    values.increment(index);
+    return *this;
+}
+
+void TreeClock::restart(int index, int value) {
+    assert(value > values[index]);
+    const int oldRoot = rootThread;
+    if (index != oldRoot) {
+        if (nodes[index].parent >= 0) {
+            detach(index);
+        }
+        rootThread = index;
+        if (oldRoot >= 0) {
+            pushChild(index, oldRoot, value);
+        }
+    }
+    values[index] = value;
+}
+
+// Unlink u from its parent's child list
+void TreeClock::detach(int u) {
+    Node& node = nodes[u];
+    if (node.prevSibling >= 0) {
+        nodes[node.prevSibling].nextSibling = node.nextSibling;
+    } else {
+        nodes[node.parent].firstChild = node.nextSibling;
+    }
+    if (node.nextSibling >= 0) {
+        nodes[node.nextSibling].prevSibling = node.prevSibling;
+    }
+    node.parent = node.prevSibling = node.nextSibling = -1;
+}
+
+// Make u the most recent child of p
+void TreeClock::pushChild(int p, int u, int aclk) {
+    Node& node = nodes[u];
+    Node& head = nodes[p];
+    node.parent = p;
+    node.attached = aclk;
+    node.prevSibling = -1;
+    node.nextSibling = head.firstChild;
+    if (head.firstChild >= 0) {
+        nodes[head.firstChild].prevSibling = u;
+    }
+    head.firstChild = u;
+}
+
+// Post-order walk of the part of other's subtree at u that this clock is
+// missing. A child this clock already knows hides its whole subtree, and
+// once a known child was attached no later than this clock's entry for u,
+// so were all the older children after it.
+void TreeClock::collectJoin(const TreeClock& other, int u, std::vector<int>& updated) const {
+    for (int v = other.nodes[u].firstChild; v >= 0; v = other.nodes[v].nextSibling) {
+        if (values[v] < other.values[v]) {
+            collectJoin(other, v, updated);
+        } else if (other.nodes[v].attached <= values[u]) {
+            break;
+        }
+    }
+    updated.push_back(u);
+}
+
+// As collectJoin, but also moves the old root, which loses its place once
+// other's root takes over
+void TreeClock::collectCopy(const TreeClock& other, int u, int oldRoot, std::vector<int>& updated) const {
+    for (int v = other.nodes[u].firstChild; v >= 0; v = other.nodes[v].nextSibling) {
+        if (values[v] < other.values[v]) {
+            collectCopy(other, v, oldRoot, updated);
+        } else {
+            if (v == oldRoot) {
+                updated.push_back(v);
+            }
+            if (other.nodes[v].attached <= values[u]) {
+                break;
+            }
+        }
+    }
+    updated.push_back(u);
+}
+
+// Move the collected nodes to their place in other, taking other's entries.
+// Parents come before their children, and each child list is rebuilt most
+// recent first.
+void TreeClock::reattach(const TreeClock& other, const std::vector<int>& updated) {
+    for (int u : updated) {
+        if (nodes[u].parent >= 0) {
+            detach(u);
+        }
+    }
+    for (auto it = updated.rbegin(); it != updated.rend(); ++it) {
+        const int u = *it;
+        values[u] = other.values[u];
+        const Node& source = other.nodes[u];
+        if (source.parent >= 0) {
+            pushChild(source.parent, u, source.attached);
+        }
+    }
+}
+
+void TreeClock::join(const TreeClock& other) {
+    DETECTOR_STAT(countStat(Counter::Joins));
+    const int z = other.rootThread;
+    if (z < 0 || other.values[z] <= values[z]) {
+        return;
+    }
+    if (rootThread < 0) {
+        copyAll(other);
+        return;
+    }
+    assert(z != rootThread);
+    std::vector<int>& updated = scratch();
+    collectJoin(other, z, updated);
+    DETECTOR_STAT(countStat(Counter::EntriesTouched, updated.size()));
+    reattach(other, updated);
+    pushChild(rootThread, z, values[rootThread]);
+}
+
+void TreeClock::joinInto(TreeClock& target) const {
+    target.join(*this);
+}
+
+void TreeClock::copyAll(const TreeClock& other) {
+    values.assignFrom(other.values);
+    nodes = other.nodes;
+    rootThread = other.rootThread;
+}
+
+TreeClock& TreeClock::assignFrom(const TreeClock& other) {
+    if (this == &other) {
+        return *this;
+    }
+    const int z = rootThread;
+    if (z < 0 || other.rootThread < 0 || size() != other.size() || other.values[z] < values[z]) {
+        copyAll(other);
+        return *this;
+    }
+    std::vector<int>& updated = scratch();
+    collectCopy(other, other.rootThread, z, updated);
+    DETECTOR_STAT(countClockOp(Counter::Copies, updated.size()));
+    reattach(other, updated);
+    rootThread = other.rootThread;
+    return *this;
+}
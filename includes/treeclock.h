@@ -0,0 +1,82 @@
+#ifndef TREECLOCK_H
+#define TREECLOCK_H
+
+#include "vectorclock.h"
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Vector clock that also remembers how it learnt each entry: every thread u
+// it knows about hangs below the thread it heard about u from (its parent),
+// together with the parent's clock at that moment (aclk). The owning thread
+// is the root, and children are kept most recently attached first.
+//
+// Joining T' into T walks T' from its root. It skips a whole subtree once T
+// already knows that subtree's root, and it stops scanning a child list once
+// the remaining children were attached before T last heard from their
+// parent. Join and (monotone) copy therefore cost time proportional to the
+// entries that change, not to the number of threads. The flat entries are
+// kept in a VectorClock, so comparisons still run on the SIMD kernels.
+//
+// This relies on every clock being the causal past of its root's latest
+// event, which holds for the thread and lock clocks of the detector: if T
+// knows T'.root at T'[T'.root], it already knows all of T'.
+class TreeClock {
+    // Tree links of one thread, kept together so moving a node touches a
+    // single cache line
+    struct Node {
+        int parent = -1;        // -1 for the root and for unknown threads
+        int attached = 0;       // parent's entry when the node was attached
+        int firstChild = -1;
+        int nextSibling = -1;
+        int prevSibling = -1;
+    };
+
+    VectorClock values;
+    std::vector<Node> nodes;
+    int rootThread = -1;
+
+    void detach(int u);
+    void pushChild(int p, int u, int aclk);
+    void collectJoin(const TreeClock& other, int u, std::vector<int>& updated) const;
+    void collectCopy(const TreeClock& other, int u, int oldRoot, std::vector<int>& updated) const;
+    void reattach(const TreeClock& other, const std::vector<int>& updated);
+    void join(const TreeClock& other);
+    void copyAll(const TreeClock& other);
+public:
+    TreeClock() = default;
+    // Empty clock; the first increment makes the incremented thread the root
+    explicit TreeClock(int num_threads);
+
+    int size() const { return values.size(); }
+    int root() const { return rootThread; }
+    const int* data() const { return values.data(); }
+    int operator[](std::size_t index) const { return values[index]; }
+
+    // The flat entries, for comparing against plain vector clocks
+    operator const VectorClock&() const { return values; }
+
+    // Grow to num_threads entries; new threads are unknown
+    void resize(int num_threads);
+
+    // Tick the root's own entry. Only the root may be incremented.
+    TreeClock& increment(int index);
+    // Make index the root with entry value, which must exceed the current
+    // one, when the clock's thread moves to another slot. The old root
+    // becomes its most recent child.
+    void restart(int index, int value);
+
+    // target := max(target, *this)
+    void joinInto(TreeClock& target) const;
+    // Overwrite with other. Sublinear when other has seen this clock's root
+    // event (so *this <= other), as on a lock release; a full copy otherwise.
+    TreeClock& assignFrom(const TreeClock& other);
+
+    bool operator<=(const TreeClock& other) const { return values <= other.values; }
+    // Smallest index whose entry exceeds other's, or -1 if *this <= other
+    int findGreater(const TreeClock& other) const { return values.findGreater(other.values); }
+
+    friend std::ostream& operator<<(std::ostream& os, const TreeClock& tc) { return os << tc.values; }
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include "treeclockstate.h"
+#include "stats.h"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+// Constructor
+TreeClockState::TreeClockState(int num_threads) : width(num_threads > 0 ? num_threads : 0) {
+    if (num_threads > 0) {
+        addThread(num_threads - 1);
+    }
+    // The initial threads take slots 0..n-1 right away
+    initialThreads = numThreads();
+    for (int i = 0; i < initialThreads; ++i) {
+        slot(i);
+    }
+}
+
+int TreeClockState::numThreads() const {
+    return slots.threads();
+}
+
+int TreeClockState::clockWidth() const {
+    return width;
+}
+
+int TreeClockState::addThread(int index) {
+    if (index < 0) {
+        throw std::out_of_range("Unknown thread " + std::to_string(index));
+    }
+    while (numThreads() <= index) {
+        C.emplace_back(width);
+        slots.declare(numThreads());
+    }
+    return index;
+}
+
+void TreeClockState::widen(int num_slots) {
+    if (num_slots <= width) {
+        return;
+    }
+    width = num_slots;
+    for (auto& clock : C) clock.resize(width);
+    for (auto& clock : L) clock.resize(width);
+    for (auto& r : R) {
+        if (r.isShared()) r.shared->resize(width);
+    }
+}
+
+int TreeClockState::slot(int index) {
+    if (index < 0 || index >= numThreads()) {
+        throw std::out_of_range("Unknown thread " + std::to_string(index));
+    }
+    if (!slots.active(index)) {
+        const Epoch e = slots.activate(index, C[index]);
+        widen(slots.slots());
+        C[index].restart(e.thread, e.clock);
+    }
+    return slots.slot(index);
+}
+
+int TreeClockState::addLock(std::string_view name) {
+    int id = lockSymbols.intern(name);
+    if (id >= static_cast<int>(L.size())) {
+        L.emplace_back(width);
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+    }
+    return id;
+}
+
+int TreeClockState::lockId(std::string_view name) const {
+    int id = lockSymbols.find(name);
+    if (id < 0) {
+        throw std::out_of_range("Unknown lock or atomic object: " + std::string(name));
+    }
+    return id;
+}
+
+int TreeClockState::locationId(std::string_view name) {
+    int id = locationSymbols.intern(name);
+    if (id >= static_cast<int>(R.size())) {
+        R.resize(id + 1);
+        W.resize(id + 1);
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+    }
+    return id;
+}
+
+int TreeClockState::addressId(std::uint64_t address) {
+    int& cell = addresses.cell(address);
+    if (cell == 0) {
+        // Named only when printed
+        const int id = locationSymbols.addAddress(addresses.granule(address));
+        R.resize(id + 1);
+        W.resize(id + 1);
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+        cell = id + 1;
+    }
+    return cell - 1;
+}
+
+void TreeClockState::setAddressGranularity(int bytes) {
+    if (addresses.used()) {
+        throw std::logic_error("Address granularity cannot change after addresses are mapped");
+    }
+    addresses = ShadowMemory(bytes);
+}
+
+int TreeClockState::addressGranularity() const {
+    return addresses.granularity();
+}
+
+const SymbolTable& TreeClockState::locks() const { return lockSymbols; }
+const SymbolTable& TreeClockState::locations() const { return locationSymbols; }
+
+// Update a specific clock of C
+void TreeClockState::updateC(int index, const TreeClock& newClock) {
+    if (index >= 0 && index < numThreads()) {
+        C[index] = newClock;
+    }
+}
+
+// Update the clock of a lock or atomic object
+void TreeClockState::updateL(int id, const TreeClock& newClock) {
+    L[id] = newClock;
+}
+
+// Record the last write epoch of a location
+void TreeClockState::updateW(int id, const Epoch& epoch) {
+    W[id] = epoch;
+}
+
+void TreeClockState::joinLIntoC(int id, int index) {
+    slot(index);
+    L[id].joinInto(C[index]);
+}
+
+void TreeClockState::assignCToL(int index, int id) {
+    slot(index);
+    L[id].assignFrom(C[index]);
+}
+
+void TreeClockState::tick(int index) {
+    C[index].increment(slot(index));
+}
+
+void TreeClockState::forkThread(int parent, int child) {
+    addThread(child);
+    slot(parent);
+    if (slots.active(child)) {
+        C[parent].joinInto(C[child]);
+        tick(parent);
+        return;
+    }
+    // The child takes a slot the parent has seen finish, or a new one. Its
+    // clock is rebuilt below the new root so that what it knew from before
+    // it was joined, if anything, does not hang below a stale one.
+    const Epoch e = slots.activate(child, C[parent]);
+    widen(slots.slots());
+    TreeClock clock = C[parent];
+    clock.restart(e.thread, e.clock);
+    C[child].joinInto(clock);
+    C[child] = std::move(clock);
+    tick(parent);
+}
+
+void TreeClockState::joinThread(int parent, int child) {
+    const int s = slot(child);
+    slot(parent);
+    C[child].joinInto(C[parent]);
+    C[child].increment(s);
+    slots.retire(child, C[child][s]);
+}
+
+// Accessor methods to get references; IDs must come from addLock/locationId
+TreeClock& TreeClockState::getC(int index) { return C.at(index); }
+const TreeClock& TreeClockState::getL(int id) const { return L[id]; }
+BasicReadShadow<VectorClock>& TreeClockState::getR(int id) { return R[id]; }
+Epoch& TreeClockState::getW(int id) { return W[id]; }
+
+VectorClock& TreeClockState::sharedRead(const BasicReadShadow<VectorClock>& r) {
+    return *r.shared;
+}
+
+void TreeClockState::inflate(BasicReadShadow<VectorClock>& r, const Epoch& e) {
+    r.inflate(width, e);
+}
+
+void TreeClockState::collapse(BasicReadShadow<VectorClock>& r, const Epoch& e) {
+    r.collapse(e);
+}
+
+Epoch TreeClockState::epoch(int index) {
+    const int s = slot(index);
+    return Epoch(s, C[index][s]);
+}
+
+int TreeClockState::threadOf(const Epoch& e) const {
+    return slots.threadOf(e);
+}
+
+void TreeClockState::reset() {
+    std::fill(R.begin(), R.end(), BasicReadShadow<VectorClock>());
+    std::fill(W.begin(), W.end(), Epoch());
+    std::fill(L.begin(), L.end(), TreeClock(width));
+    std::fill(C.begin(), C.end(), TreeClock(width));
+    slots.reset(initialThreads);
+    for (int i = 0; i < initialThreads; ++i) {
+        C[i].increment(i);
+    }
+}
+
+// Overload << operator for printing
+std::ostream& operator<<(std::ostream& os, const TreeClockState& tcs) {
+    os << "\nC: ";
+    for (const auto& tc : tcs.C) os << tc << ", ";
+    os << "\nL: ";
+    for (int i = 0; i < tcs.lockSymbols.size(); ++i) os << "{" << tcs.lockSymbols.name(i) << ": " << tcs.L[i] << "}, ";
+    os << "\nR: ";
+    for (int i = 0; i < tcs.locationSymbols.size(); ++i) os << "{" << tcs.locationSymbols.name(i) << ": " << tcs.R[i] << "}, ";
+    os << "\nW: ";
+    for (int i = 0; i < tcs.locationSymbols.size(); ++i) os << "{" << tcs.locationSymbols.name(i) << ": " << tcs.W[i] << "}";
+    return os;
+}
@@ -0,0 +1,107 @@
+#ifndef TREECLOCKSTATE_H
+#define TREECLOCKSTATE_H
+
+#include "treeclock.h"
+#include "vectorclock.h"
+#include "epoch.h"
+#include "symboltable.h"
+#include "shadowmemory.h"
+#include "parallelhandle.h"
+#include "threadslots.h"
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <iostream>
+
+// VectorClockState with thread and lock clocks kept as TreeClocks, so
+// acquires and releases only touch the entries that change. Read-shared
+// clocks are only ever updated one entry at a time and stay flat
+// VectorClocks. Suited to many threads contending on few locks. Clock
+// entries are indexed by slot, as in VectorClockState.
+class TreeClockState {
+    std::vector<TreeClock> C;
+    std::vector<TreeClock> L;
+    std::vector<BasicReadShadow<VectorClock>> R;
+    std::vector<Epoch> W;
+    SymbolTable lockSymbols, locationSymbols;
+    ShadowMemory addresses;
+    ParallelHandle parallel;
+    ThreadSlots slots;
+    int initialThreads = 0;
+    int width = 0;
+
+    // Slot of thread t, giving it one on first use
+    int slot(int index);
+    // Give every clock at least num_slots entries
+    void widen(int num_slots);
+public:
+    // All threads start at C[t][t] = 1, everything else at zero
+    explicit TreeClockState(int num_threads);
+
+    int numThreads() const;
+    int clockWidth() const;
+
+    // Make sure thread t exists; returns t. A new thread gets its slot when
+    // it first acts or is forked.
+    int addThread(int index);
+
+    // ID of a lock or atomic object, creating its zero clock on first use
+    int addLock(std::string_view name);
+    // ID of an existing lock or atomic object; throws std::out_of_range otherwise
+    int lockId(std::string_view name) const;
+    // ID of a shared location, creating its shadow on first use
+    int locationId(std::string_view name);
+    // ID of the location holding address, creating it on first use
+    int addressId(std::uint64_t address);
+
+    // Granule size for addressId: 1, 4 or 8 bytes (default 8). Throws
+    // std::logic_error once an address has been mapped.
+    void setAddressGranularity(int bytes);
+    int addressGranularity() const;
+
+    const SymbolTable& locks() const;
+    const SymbolTable& locations() const;
+
+    void updateC(int index, const TreeClock& newClock);
+    void updateL(int id, const TreeClock& newClock);
+    void updateW(int id, const Epoch& epoch);
+
+    // C[t] := max(C[t], L[id]), visiting only the entries L[id] adds
+    void joinLIntoC(int id, int index);
+    // L[id] := C[t], visiting only the entries that change
+    void assignCToL(int index, int id);
+    // Tick thread t's own entry
+    void tick(int index);
+    // C[child] := max(C[child], C[parent]), then tick the parent
+    void forkThread(int parent, int child);
+    // C[parent] := max(C[parent], C[child]), then tick the child and free
+    // its slot for reuse
+    void joinThread(int parent, int child);
+
+    // Does not give t a slot
+    TreeClock& getC(int index);
+    const TreeClock& getL(int id) const;
+    BasicReadShadow<VectorClock>& getR(int id);
+    Epoch& getW(int id);
+
+    // Read-shared clock of r, which must be isShared()
+    VectorClock& sharedRead(const BasicReadShadow<VectorClock>& r);
+    void inflate(BasicReadShadow<VectorClock>& r, const Epoch& e);
+    void collapse(BasicReadShadow<VectorClock>& r, const Epoch& e);
+
+    // Current epoch C[t][s]@s of thread t on its slot s
+    Epoch epoch(int index);
+    // Thread that made the event at epoch e
+    int threadOf(const Epoch& e) const;
+
+    // Back to the initial clocks, keeping every declared object
+    void reset();
+
+    // Shards and workers detectParallel keeps between calls on this state
+    ParallelContext& parallelContext() { return parallel.get(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const TreeClockState& tcs);
+};
+
+#endif
@@ -1,67 +1,147 @@
+#include "vectorclock.h"
+#include "clockkernels.h"
+#include "stats.h"
 #include <vector>
 #include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <new>
+#include <utility>
 
-class VectorClock {
-private:
+// Size the storage for num_threads zeroed entries, inline when it fits
+void VectorClock::allocate(int num_threads) {
+    width = num_threads;
+    capacity = static_cast<int>(paddedWidth(num_threads));
+    if (onHeap()) {
+        heap = static_cast<int*>(::operator new(capacity * sizeof(int), std::align_val_t(CLOCK_ALIGNMENT)));
+    }
+    std::fill(entries(), entries() + capacity, 0);
+}
 
-public:
-    std::vector<int> vector;
-    // Default constructor
-    VectorClock() = default;
+void VectorClock::release() {
+    if (onHeap()) {
+        ::operator delete(heap, std::align_val_t(CLOCK_ALIGNMENT));
+    }
+    width = 0;
+    capacity = 0;
+}
 
-    // Constructor with number of threads
-    VectorClock(int num_threads) : vector(num_threads, 0) {}
+// Default constructor
+VectorClock::VectorClock() {}
 
-    // Constructor with number of threads and initial values
-    VectorClock(int num_threads, const std::vector<int>& values) {
-        if (values.empty()) {
-            vector.resize(num_threads, 0);
-        } else {
-            assert(num_threads == values.size());
-            vector = values;
-        }
+// Constructor with number of threads
+VectorClock::VectorClock(int num_threads) {
+    allocate(num_threads);
+}
+
+// Constructor with number of threads and initial values
+VectorClock::VectorClock(int num_threads, const std::vector<int>& values) : VectorClock(num_threads) {
+    if (!values.empty()) {
+        assert(num_threads == static_cast<int>(values.size()));
+        std::copy(values.begin(), values.end(), entries());
     }
+}
 
-    // Increment function
-    VectorClock& increment(int index) {
-        if (index >= 0 && index < vector.size()) {
-            vector[index]++;
-        }
-        return *this;
+VectorClock::VectorClock(const VectorClock& other) {
+    allocate(other.width);
+    std::copy(other.data(), other.data() + capacity, entries());
+}
+
+VectorClock::VectorClock(VectorClock&& other) noexcept : width(other.width), capacity(other.capacity) {
+    if (other.onHeap()) {
+        heap = other.heap;
+        other.width = 0;
+        other.capacity = 0;
+    } else {
+        std::copy(other.local, other.local + capacity, local);
     }
+}
 
-    // Overload [] operator for getting elements
-    int operator[](size_t index) const {
-        return vector[index];
+VectorClock& VectorClock::operator=(const VectorClock& other) {
+    if (this != &other) {
+        assignFrom(other);
     }
+    return *this;
+}
 
-    // Overload [] operator for setting elements
-    int& operator[](size_t index) {
-        return vector[index];
+VectorClock& VectorClock::operator=(VectorClock&& other) noexcept {
+    if (this != &other) {
+        if (other.onHeap()) {
+            release();
+            heap = other.heap;
+            width = other.width;
+            capacity = other.capacity;
+            other.width = 0;
+            other.capacity = 0;
+        } else {
+            assignFrom(other);
+        }
     }
+    return *this;
+}
 
-    // Overload + operator for joining two VectorClocks
-    VectorClock operator+(const VectorClock& other) const {
-        std::vector<int> joined_vec(vector.size());
-        std::transform(vector.begin(), vector.end(), other.vector.begin(), joined_vec.begin(), [](int a, int b) { return std::max(a, b); });
-        return VectorClock(static_cast<int>(joined_vec.size()), joined_vec);
+VectorClock::~VectorClock() {
+    release();
+}
+
+void VectorClock::resize(int num_threads) {
+    if (num_threads <= width) {
+        return;
     }
+    VectorClock wider(num_threads);
+    std::copy(data(), data() + width, wider.entries());
+    *this = std::move(wider);
+}
 
-    // Overload <= operator to compare VectorClocks
-    bool operator<=(const VectorClock& other) const {
-        return std::equal(vector.begin(), vector.end(), other.vector.begin(), std::less_equal<>());
+// Increment function
+VectorClock& VectorClock::increment(int index) {
+    if (index >= 0 && index < width) {
+        entries()[index]++;
     }
+    return *this;
+}
 
-    // Friend function for ostream to print VectorClock
-    friend std::ostream& operator<<(std::ostream& os, const VectorClock& vc) {
-        os << '[';
-        for (size_t i = 0; i < vc.vector.size(); i++) {
-            os << vc.vector[i];
-            if (i < vc.vector.size() - 1) os << ", ";
-        }
-        os << ']';
-        return os;
+// Overload + operator for joining two VectorClocks
+VectorClock VectorClock::operator+(const VectorClock& other) const {
+    VectorClock joined(*this);
+    other.joinInto(joined);
+    return joined;
+}
+
+// Overload <= operator to compare VectorClocks
+bool VectorClock::operator<=(const VectorClock& other) const {
+    assert(width == other.width);
+    return clockLeq(data(), other.data(), capacity);
+}
+
+void VectorClock::joinInto(VectorClock& target) const {
+    assert(width == target.width);
+    clockJoin(target.entries(), data(), capacity);
+}
+
+VectorClock& VectorClock::assignFrom(const VectorClock& other) {
+    if (capacity != other.capacity) {
+        release();
+        allocate(other.width);
+    }
+    width = other.width;
+    DETECTOR_STAT(countClockOp(Counter::Copies, capacity));
+    std::copy(other.data(), other.data() + capacity, entries());
+    return *this;
+}
+
+int VectorClock::findGreater(const VectorClock& other) const {
+    assert(width == other.width);
+    return clockFindGreater(data(), other.data(), capacity);
+}
+
+// Friend function for ostream to print VectorClock
+std::ostream& operator<<(std::ostream& os, const VectorClock& vc) {
+    os << '[';
+    for (int i = 0; i < vc.width; i++) {
+        os << vc[i];
+        if (i < vc.width - 1) os << ", ";
     }
-};
\ No newline at end of file
+    os << ']';
+    return os;
+}
@@ -1,19 +1,69 @@
+#ifndef VECTORCLOCK_H
+#define VECTORCLOCK_H
+
+#include "clockkernels.h"
+#include <cstddef>
 #include <vector>
 #include <algorithm>
 #include <iostream>
 
+// Clocks up to this many threads are stored inline in the object; wider
+// clocks spill to a heap buffer. Override with -DVECTORCLOCK_INLINE_WIDTH=N.
+#ifndef VECTORCLOCK_INLINE_WIDTH
+#define VECTORCLOCK_INLINE_WIDTH 32
+#endif
+
+// Entries are stored CLOCK_ALIGNMENT-aligned and zero-padded to a multiple
+// of CLOCK_LANES so join and compare can run on the SIMD clock kernels.
+// Clocks that are joined or compared must have the same width.
 class VectorClock {
 public:
-    std::vector<int> vector;
+    static constexpr int INLINE_WIDTH = static_cast<int>(paddedWidth(VECTORCLOCK_INLINE_WIDTH));
+
+private:
+    union {
+        alignas(CLOCK_ALIGNMENT) int local[INLINE_WIDTH];
+        int* heap;
+    };
+    int width = 0;
+    int capacity = 0;  // padded entry count; > INLINE_WIDTH means heap storage
+
+    bool onHeap() const { return capacity > INLINE_WIDTH; }
+    int* entries() { return onHeap() ? heap : local; }
+    void allocate(int num_threads);
+    void release();
+
+public:
     VectorClock();
     VectorClock(int num_threads);
     VectorClock(int num_threads, const std::vector<int>& values);
+    VectorClock(const VectorClock& other);
+    VectorClock(VectorClock&& other) noexcept;
+    VectorClock& operator=(const VectorClock& other);
+    VectorClock& operator=(VectorClock&& other) noexcept;
+    ~VectorClock();
+
+    int size() const { return width; }
+    // Grow to num_threads entries, keeping the current ones; new entries are zero
+    void resize(int num_threads);
+    bool empty() const { return width == 0; }
+    const int* data() const { return onHeap() ? heap : local; }
 
     VectorClock& increment(int index);
-    int operator[](size_t index) const;
-    int& operator[](size_t index);
+    int operator[](size_t index) const { return data()[index]; }
+    int& operator[](size_t index) { return entries()[index]; }
     VectorClock operator+(const VectorClock& other) const;
     bool operator<=(const VectorClock& other) const;
 
+    // In-place join target := max(target, *this), without allocating
+    void joinInto(VectorClock& target) const;
+    // Overwrite with other's entries, reusing this clock's buffer
+    VectorClock& assignFrom(const VectorClock& other);
+
+    // Smallest index whose entry exceeds other's, or -1 if *this <= other
+    int findGreater(const VectorClock& other) const;
+
     friend std::ostream& operator<<(std::ostream& os, const VectorClock& vc);
-};
\ No newline at end of file
+};
+
+#endif
@@ -1,70 +1,242 @@
-#include "vectorclock.h"
-#include <unordered_map>
+#include "vectorclockstate.h"
+#include "stats.h"
+#include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <stdexcept>
+#include <algorithm>
 
-class VectorClockState {
-private:
-    std::vector<VectorClock> C;
-    std::unordered_map<std::string, VectorClock> L, R, W;
-
-public:
-    // Constructor
-    VectorClockState(const std::vector<VectorClock>& c, 
-                     const std::unordered_map<std::string, VectorClock>& l,
-                     const std::unordered_map<std::string, VectorClock>& r,
-                     const std::unordered_map<std::string, VectorClock>& w)
-        : C(c), L(l), R(r), W(w) {}
-
-    // const VectorClock& getC(int index) const { return C[index]; }
-    // const VectorClock& getL(const std::string& key) const { return L.at(key); }
-    // const VectorClock& getR(const std::string& key) const { return R.at(key); }
-    // const VectorClock& getW(const std::string& key) const { return W.at(key); }
-
-    // Update a specific VectorClock in the vector C
-    void updateC(int index, const VectorClock& newClock) {
-        if (index >= 0 && index < C.size()) {
-            C[index] = newClock;
-        }
+// Copy a clock of any width into a row, dropping entries past the row's width
+// and zeroing the entries it does not cover
+static void copyInto(ClockRow row, const VectorClock& clock) {
+    int n = std::min(row.size(), clock.size());
+    std::copy(clock.data(), clock.data() + n, row.data());
+    std::fill(row.data() + n, row.data() + row.size(), 0);
+}
+
+// Constructor
+VectorClockState::VectorClockState(int num_threads) : clocks(num_threads) {
+    if (num_threads > 0) {
+        addThread(num_threads - 1);
+    }
+    // The initial threads take slots 0..n-1 right away
+    initialThreads = numThreads();
+    for (int i = 0; i < initialThreads; ++i) {
+        slot(i);
     }
+}
+
+int VectorClockState::numThreads() const {
+    return slots.threads();
+}
+
+int VectorClockState::clockWidth() const {
+    return clocks.width();
+}
 
-    // Update a specific VectorClock in the map L
-    void updateL(const std::string& key, const VectorClock& newClock) {
-        L[key] = newClock;
+int VectorClockState::addThread(int index) {
+    if (index < 0) {
+        throw std::out_of_range("Unknown thread " + std::to_string(index));
     }
+    while (numThreads() <= index) {
+        threadRows.push_back(clocks.allocate());
+        slots.declare(numThreads());
+    }
+    return index;
+}
 
-    // Update a specific entry in the map R
-    void updateR(const std::string& key, int index, int value) {
-        if (R.find(key) != R.end() && index >= 0 && index < R[key].vector.size()) {
-            R[key].vector[index] = value;
-        }
+int VectorClockState::slot(int index) {
+    if (index < 0 || index >= numThreads()) {
+        throw std::out_of_range("Unknown thread " + std::to_string(index));
+    }
+    if (!slots.active(index)) {
+        const Epoch e = slots.activate(index, clocks.row(threadRows[index]));
+        clocks.widen(slots.slots());
+        clocks.row(threadRows[index])[e.thread] = e.clock;
     }
+    return slots.slot(index);
+}
 
-    // Update a specific entry in the map W
-    void updateW(const std::string& key, int index, int value) {
-        if (W.find(key) != W.end() && index >= 0 && index < W[key].vector.size()) {
-            W[key].vector[index] = value;
-        }
+int VectorClockState::addLock(std::string_view name) {
+    int id = lockSymbols.intern(name);
+    if (id >= static_cast<int>(lockRows.size())) {
+        lockRows.push_back(clocks.allocate());
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+    }
+    return id;
+}
+
+int VectorClockState::lockId(std::string_view name) const {
+    int id = lockSymbols.find(name);
+    if (id < 0) {
+        throw std::out_of_range("Unknown lock or atomic object: " + std::string(name));
+    }
+    return id;
+}
+
+int VectorClockState::locationId(std::string_view name) {
+    int id = locationSymbols.intern(name);
+    if (id >= static_cast<int>(R.size())) {
+        R.resize(id + 1);
+        W.resize(id + 1);
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+    }
+    return id;
+}
+
+int VectorClockState::addressId(std::uint64_t address) {
+    int& cell = addresses.cell(address);
+    if (cell == 0) {
+        // Named only when printed
+        const int id = locationSymbols.addAddress(addresses.granule(address));
+        R.resize(id + 1);
+        W.resize(id + 1);
+        DETECTOR_STAT(countStat(Counter::ShadowInserts));
+        cell = id + 1;
+    }
+    return cell - 1;
+}
+
+void VectorClockState::setAddressGranularity(int bytes) {
+    if (addresses.used()) {
+        throw std::logic_error("Address granularity cannot change after addresses are mapped");
+    }
+    addresses = ShadowMemory(bytes);
+}
+
+int VectorClockState::addressGranularity() const {
+    return addresses.granularity();
+}
+
+const SymbolTable& VectorClockState::locks() const { return lockSymbols; }
+const SymbolTable& VectorClockState::locations() const { return locationSymbols; }
+
+// Update a specific clock of C
+void VectorClockState::updateC(int index, const VectorClock& newClock) {
+    if (index >= 0 && index < numThreads()) {
+        copyInto(clocks.row(threadRows[index]), newClock);
+    }
+}
+
+// Update the clock of a lock or atomic object
+void VectorClockState::updateL(int id, const VectorClock& newClock) {
+    copyInto(clocks.row(lockRows[id]), newClock);
+}
+
+// Record the last write epoch of a location
+void VectorClockState::updateW(int id, const Epoch& epoch) {
+    W[id] = epoch;
+}
+
+// Rows are looked up only after slot(), which may widen the arena
+
+void VectorClockState::joinLIntoC(int id, int index) {
+    slot(index);
+    clocks.row(lockRows[id]).joinInto(clocks.row(threadRows[index]));
+}
+
+void VectorClockState::assignCToL(int index, int id) {
+    slot(index);
+    clocks.row(lockRows[id]).assignFrom(clocks.row(threadRows[index]));
+}
+
+void VectorClockState::tick(int index) {
+    const int s = slot(index);
+    clocks.row(threadRows[index]).increment(s);
+}
+
+void VectorClockState::forkThread(int parent, int child) {
+    addThread(child);
+    slot(parent);
+    if (!slots.active(child)) {
+        // A slot the parent has seen finish, or a new one
+        const Epoch e = slots.activate(child, clocks.row(threadRows[parent]));
+        clocks.widen(slots.slots());
+        clocks.row(threadRows[child])[e.thread] = e.clock;
+    }
+    clocks.row(threadRows[parent]).joinInto(clocks.row(threadRows[child]));
+    tick(parent);
+}
+
+void VectorClockState::joinThread(int parent, int child) {
+    const int s = slot(child);
+    slot(parent);
+    ClockRow c = clocks.row(threadRows[child]);
+    c.joinInto(clocks.row(threadRows[parent]));
+    c.increment(s);
+    slots.retire(child, c[s]);
+}
+
+// Accessor methods; IDs must come from addLock/locationId
+ClockRow VectorClockState::getC(int index) {
+    if (index < 0 || index >= numThreads()) {
+        throw std::out_of_range("Unknown thread " + std::to_string(index));
     }
+    return clocks.row(threadRows[index]);
+}
+
+ConstClockRow VectorClockState::getL(int id) const { return clocks.row(lockRows[id]); }
+ReadShadow& VectorClockState::getR(int id) { return R[id]; }
+Epoch& VectorClockState::getW(int id) { return W[id]; }
+
+ClockRow VectorClockState::sharedRead(const ReadShadow& r) {
+    return clocks.row(r.sharedRow);
+}
+
+void VectorClockState::inflate(ReadShadow& r, const Epoch& e) {
+    r.sharedRow = clocks.allocate();
+    ClockRow shared = clocks.row(r.sharedRow);
+    shared[r.epoch.thread] = r.epoch.clock;
+    shared[e.thread] = e.clock;
+}
 
-    // Accessor methods to get references (consider the safety of these operations)
-    VectorClock& getC(int index) { return C.at(index); }
-    const VectorClock& getL(const std::string& key) const { return L.at(key); }
-    VectorClock& getR(const std::string& key) { return R[key]; }
-    VectorClock& getW(const std::string& key) { return W[key]; }
+void VectorClockState::collapse(ReadShadow& r, const Epoch& e) {
+    clocks.free(r.sharedRow);
+    r.sharedRow = -1;
+    r.epoch = e;
+}
 
+Epoch VectorClockState::epoch(int index) {
+    const int s = slot(index);
+    return Epoch(s, clocks.row(threadRows[index])[s]);
+}
+
+int VectorClockState::threadOf(const Epoch& e) const {
+    return slots.threadOf(e);
+}
+
+void VectorClockState::reset() {
+    for (auto& r : R) {
+        if (r.isShared()) {
+            clocks.free(r.sharedRow);
+        }
+        r = ReadShadow();
+    }
+    std::fill(W.begin(), W.end(), Epoch());
+    clocks.reset();
+    slots.reset(initialThreads);
+    for (int i = 0; i < initialThreads; ++i) {
+        clocks.row(threadRows[i]).increment(i);
+    }
+}
 
+const ClockArena& VectorClockState::arena() const { return clocks; }
 
-    // Overload << operator for printing
-    friend std::ostream& operator<<(std::ostream& os, const VectorClockState& vcs) {
-        os << "\nC: ";
-        for (const auto& vc : vcs.C) os << vc << ", ";
-        os << "\nL: ";
-        for (const auto& pair : vcs.L) os << "{" << pair.first << ": " << pair.second << "}, ";
-        os << "\nR: ";
-        for (const auto& pair : vcs.R) os << "{" << pair.first << ": " << pair.second << "}, ";
-        os << "\nW: ";
-        for (const auto& pair : vcs.W) os << "{" << pair.first << ": " << pair.second << "}";
-        return os;
+// Overload << operator for printing
+std::ostream& operator<<(std::ostream& os, const VectorClockState& vcs) {
+    os << "\nC: ";
+    for (int i = 0; i < vcs.numThreads(); ++i) os << vcs.clocks.row(vcs.threadRows[i]) << ", ";
+    os << "\nL: ";
+    for (int i = 0; i < vcs.lockSymbols.size(); ++i) os << "{" << vcs.lockSymbols.name(i) << ": " << vcs.clocks.row(vcs.lockRows[i]) << "}, ";
+    os << "\nR: ";
+    for (int i = 0; i < vcs.locationSymbols.size(); ++i) {
+        os << "{" << vcs.locationSymbols.name(i) << ": ";
+        if (vcs.R[i].isShared()) os << vcs.clocks.row(vcs.R[i].sharedRow);
+        else os << vcs.R[i].epoch;
+        os << "}, ";
     }
-};
+    os << "\nW: ";
+    for (int i = 0; i < vcs.locationSymbols.size(); ++i) os << "{" << vcs.locationSymbols.name(i) << ": " << vcs.W[i] << "}";
+    return os;
+}
@@ -1,30 +1,126 @@
+#ifndef VECTORCLOCKSTATE_H
+#define VECTORCLOCKSTATE_H
+
 #include "vectorclock.h"
-#include <unordered_map>
+#include "clockarena.h"
+#include "epoch.h"
+#include "symboltable.h"
+#include "shadowmemory.h"
+#include "parallelhandle.h"
+#include "threadslots.h"
+#include <cstdint>
+#include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 
+// Read shadow of a location: an epoch, or the arena row of its read-shared
+// clock once two reads have been concurrent.
+struct ReadShadow {
+    Epoch epoch;
+    int sharedRow = -1;
+
+    bool isShared() const { return sharedRow >= 0; }
+};
+
+// Shadow state of the detector. Locks and atomic objects share one ID space
+// (both are kept in L), shared locations another (R and W).
+//
+// Every vector clock lives in one ClockArena: the rows of C (one per thread,
+// in threadRows), of L (one per lock, in lockRows) and of inflated
+// read-shared clocks (referenced from R). Clock entries are indexed by slot
+// (see threadslots.h), not by thread ID: threads can be added at any time,
+// e.g. by Fork, but the clocks only grow when more threads are alive at once
+// than before, since a joined thread's slot is reused.
 class VectorClockState {
-    std::vector<VectorClock> C;
-    std::unordered_map<std::string, VectorClock> L, R, W;
+    ClockArena clocks;
+    ThreadSlots slots;
+    int initialThreads = 0;
+    std::vector<int> threadRows;
+    std::vector<int> lockRows;
+    std::vector<ReadShadow> R;
+    std::vector<Epoch> W;
+    SymbolTable lockSymbols, locationSymbols;
+    ShadowMemory addresses;
+    ParallelHandle parallel;
+
+    // Slot of thread t, giving it one on first use
+    int slot(int index);
 public:
-    // VectorClockState(int num_threads, const std::vector<std::string>& locks,
-    //                  const std::vector<std::string>& atomic_objects,
-    //                  const std::vector<std::string>& shared_locations);
+    // All threads start at C[t][t] = 1, everything else at zero
+    explicit VectorClockState(int num_threads);
+
+    int numThreads() const;
+    int clockWidth() const;
+
+    // Make sure thread t exists, adding it and any lower missing IDs; returns
+    // t. A new thread gets its slot when it first acts or is forked.
+    int addThread(int index);
+
+    // ID of a lock or atomic object, creating its zero clock on first use
+    int addLock(std::string_view name);
+    // ID of an existing lock or atomic object; throws std::out_of_range otherwise
+    int lockId(std::string_view name) const;
+    // ID of a shared location, creating its shadow on first use
+    int locationId(std::string_view name);
+    // ID of the location holding address, creating it on first use. It is
+    // named after the start of its granule, e.g. "0x7ffd1000", when printed,
+    // but locationId does not find it under that name.
+    int addressId(std::uint64_t address);
+
+    // Granule size for addressId: 1, 4 or 8 bytes (default 8). Throws
+    // std::logic_error once an address has been mapped.
+    void setAddressGranularity(int bytes);
+    int addressGranularity() const;
 
-    VectorClockState(const std::vector<VectorClock>& c, 
-                     const std::unordered_map<std::string, VectorClock>& l,
-                     const std::unordered_map<std::string, VectorClock>& r,
-                     const std::unordered_map<std::string, VectorClock>& w) {}
+    const SymbolTable& locks() const;
+    const SymbolTable& locations() const;
 
     void updateC(int index, const VectorClock& newClock);
-    void updateL(const std::string& key, const VectorClock& newClock);
-    void updateR(const std::string& key, int index, int value);
-    void updateW(const std::string& key, int index, int value);
+    void updateL(int id, const VectorClock& newClock);
+    void updateW(int id, const Epoch& epoch);
 
-    VectorClock& getC(int index);
-    const VectorClock& getL(const std::string& key);
-    VectorClock& getR(const std::string& key);
-    VectorClock& getW(const std::string& key);
+    // C[t] := max(C[t], L[id]), in place
+    void joinLIntoC(int id, int index);
+    // L[id] := C[t], in place
+    void assignCToL(int index, int id);
+    // Tick thread t's own entry
+    void tick(int index);
+    // C[child] := max(C[child], C[parent]), then tick the parent
+    void forkThread(int parent, int child);
+    // C[parent] := max(C[parent], C[child]), then tick the child and free
+    // its slot for reuse
+    void joinThread(int parent, int child);
+
+    // Views into the arena; invalidated by the next row allocation and by
+    // the next thread taking a new slot. getC does not give t a slot.
+    ClockRow getC(int index);
+    ConstClockRow getL(int id) const;
+    ReadShadow& getR(int id);
+    Epoch& getW(int id);
+
+    // Read-shared clock of r, which must be isShared()
+    ClockRow sharedRead(const ReadShadow& r);
+    // Switch r to read-shared mode, keeping its epoch and adding e
+    void inflate(ReadShadow& r, const Epoch& e);
+    // Return r to epoch mode with epoch e, releasing its clock row
+    void collapse(ReadShadow& r, const Epoch& e);
+
+    // Current epoch C[t][s]@s of thread t on its slot s
+    Epoch epoch(int index);
+    // Thread that made the event at epoch e
+    int threadOf(const Epoch& e) const;
+
+    // Back to the initial clocks, keeping every declared object and the memory
+    void reset();
+
+    // Shards and workers detectParallel keeps between calls on this state
+    ParallelContext& parallelContext() { return parallel.get(); }
+
+    // The backing arena, e.g. to snapshot all clocks with one memcpy
+    const ClockArena& arena() const;
 
     friend std::ostream& operator<<(std::ostream& os, const VectorClockState& vcs);
-};
\ No newline at end of file
+};
+
+#endif
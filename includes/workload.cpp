@@ -0,0 +1,110 @@
+#include "workload.h"
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+const char* sharingName(Sharing sharing) {
+    switch (sharing) {
+    case Sharing::Private: return "private";
+    case Sharing::Uniform: return "uniform";
+    case Sharing::ReadMostly: return "read-mostly";
+    case Sharing::LockProtected: return "lock-protected";
+    }
+    return "unknown";
+}
+
+namespace {
+
+class Generator {
+    const WorkloadConfig& config;
+    const std::vector<int>& lockIds;
+    const std::vector<int>& atomicIds;
+    const std::vector<int>& locationIds;
+    std::mt19937_64 rng;
+    std::vector<Event>& events;
+    double readRatio;
+
+    int below(int n) { return static_cast<int>(rng() % static_cast<std::uint64_t>(n)); }
+    bool chance(double p) { return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p; }
+
+    // Location index for a plain access by thread t. With LockProtected,
+    // plain accesses use the lower half of the locations.
+    int plainLocation(int t) {
+        int count = static_cast<int>(locationIds.size());
+        if (config.sharing == Sharing::LockProtected) {
+            count = std::max(1, count / 2);
+        } else if (config.sharing != Sharing::Private) {
+            return below(count);
+        }
+        const int slice = std::max(1, count / config.threads);
+        return std::min(count - 1, (t * slice) % count + below(slice));
+    }
+
+    // Location index for an access inside a critical section of lock m.
+    // With LockProtected, location base + m + k * locks of the upper half
+    // belongs to lock m and is accessed nowhere else.
+    int guardedLocation(int t, int m) {
+        if (config.sharing != Sharing::LockProtected) {
+            return plainLocation(t);
+        }
+        const int count = static_cast<int>(locationIds.size());
+        const int base = std::max(1, count / 2);
+        const int locks = static_cast<int>(lockIds.size());
+        const int slots = (count - base - m + locks - 1) / locks;
+        if (slots <= 0) {
+            return plainLocation(t);
+        }
+        return base + m + locks * below(slots);
+    }
+
+    void access(int t, int index) {
+        const Opcode op = chance(readRatio) ? Opcode::Read : Opcode::Write;
+        events.push_back(Event{op, static_cast<std::uint32_t>(t), static_cast<std::uint64_t>(locationIds[index])});
+    }
+
+    void sync(Opcode op, int t, int id) {
+        events.push_back(Event{op, static_cast<std::uint32_t>(t), static_cast<std::uint64_t>(id)});
+    }
+
+public:
+    Generator(const WorkloadConfig& config, const std::vector<int>& lockIds, const std::vector<int>& atomicIds,
+              const std::vector<int>& locationIds, std::vector<Event>& events)
+        : config(config), lockIds(lockIds), atomicIds(atomicIds), locationIds(locationIds),
+          rng(config.seed), events(events),
+          readRatio(config.sharing == Sharing::ReadMostly ? 0.95 : config.readRatio) {}
+
+    void turn() {
+        const int t = below(config.threads);
+        if (!chance(config.syncRatio) || (lockIds.empty() && atomicIds.empty())) {
+            access(t, plainLocation(t));
+            return;
+        }
+        if (!atomicIds.empty() && (lockIds.empty() || chance(config.atomicRatio))) {
+            static constexpr Opcode atomicOps[] = {Opcode::AtomicLoad, Opcode::AtomicStore, Opcode::AtomicRMW};
+            sync(atomicOps[below(3)], t, atomicIds[below(static_cast<int>(atomicIds.size()))]);
+            return;
+        }
+        const int m = below(static_cast<int>(lockIds.size()));
+        sync(Opcode::Acquire, t, lockIds[m]);
+        for (int i = 0; i < config.criticalSection; ++i) {
+            access(t, guardedLocation(t, m));
+        }
+        sync(Opcode::Release, t, lockIds[m]);
+    }
+};
+
+}
+
+std::vector<Event> generateEvents(const WorkloadConfig& config, const std::vector<int>& lockIds,
+                                  const std::vector<int>& atomicIds, const std::vector<int>& locationIds) {
+    if (config.threads < 1 || locationIds.empty()) {
+        throw std::invalid_argument("A workload needs at least one thread and one location");
+    }
+    std::vector<Event> events;
+    events.reserve(config.events + config.criticalSection + 2);
+    Generator generator(config, lockIds, atomicIds, locationIds, events);
+    while (events.size() < config.events) {
+        generator.turn();
+    }
+    return events;
+}
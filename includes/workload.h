@@ -0,0 +1,66 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "event.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Synthetic traces for benchmarking. Threads take turns at random; each turn
+// is either a plain access or a synchronization block:
+//
+//  - a critical section: Acquire(m), criticalSection accesses, Release(m)
+//  - an atomic operation: one of AtomicLoad/AtomicStore/AtomicRMW on an
+//    atomic object (a fraction atomicRatio of the sync turns)
+//
+// syncRatio is the fraction of turns that synchronize, and contention is
+// set by the number of locks the critical sections pick from. The trace is
+// always well formed: a lock is only acquired while no other thread holds
+// it, since turns never interleave.
+enum class Sharing {
+    Private,        // each thread accesses only its own slice of the locations
+    Uniform,        // any thread accesses any location: unsynchronized races
+    ReadMostly,     // like Uniform, but readRatio is raised to 0.95
+    LockProtected,  // plain accesses private; critical sections of lock m access their own shared set
+};
+
+const char* sharingName(Sharing sharing);
+
+struct WorkloadConfig {
+    int threads = 8;
+    int locations = 1024;
+    int locks = 16;
+    int atomics = 4;
+    double syncRatio = 0.1;
+    double atomicRatio = 0.25;
+    double readRatio = 0.7;
+    int criticalSection = 4;
+    Sharing sharing = Sharing::Private;
+    std::size_t events = std::size_t(1) << 20;
+    unsigned seed = 1;
+};
+
+// Events for config over the given lock, atomic and location IDs. The last
+// critical section is completed, so there may be a few more than config.events.
+std::vector<Event> generateEvents(const WorkloadConfig& config, const std::vector<int>& lockIds,
+                                  const std::vector<int>& atomicIds, const std::vector<int>& locationIds);
+
+// Declare the workload's threads and objects on target (a VectorClockState
+// or a Detector) and generate its events
+template <typename Target>
+std::vector<Event> generateWorkload(Target& target, const WorkloadConfig& config) {
+    target.addThread(config.threads - 1);
+    std::vector<int> lockIds, atomicIds, locationIds;
+    for (int i = 0; i < config.locks; ++i) {
+        lockIds.push_back(target.addLock("m" + std::to_string(i)));
+    }
+    for (int i = 0; i < config.atomics; ++i) {
+        atomicIds.push_back(target.addLock("a" + std::to_string(i)));
+    }
+    for (int i = 0; i < config.locations; ++i) {
+        locationIds.push_back(target.locationId("x" + std::to_string(i)));
+    }
+    return generateEvents(config, lockIds, atomicIds, locationIds);
+}
+
+#endif
@@ -1,4 +1,10 @@
 #include "includes/run.h"
+#include "includes/detector.h"
+#include "includes/online.h"
+#include "includes/pipeline.h"
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 void ReadWriteRaceExample() {
     int threads = 2;
@@ -129,6 +135,352 @@ void SolveWriteReadRaceExample() {
 }
 
 
+void CollectAllRacesExample() {
+    int threads = 3;
+    std::vector<std::string> locks;
+    std::vector<std::string> atomic_objects;
+    std::vector<std::string> shared_locations = {"x", "y"};
+
+    auto state = initialVectorClockState(threads, locks, atomic_objects, shared_locations);
+    std::vector<std::shared_ptr<Instruction>> program = {
+        std::make_shared<Write>(0, "x"),
+        std::make_shared<Write>(1, "x"),  // Races with thread 0's write
+        std::make_shared<Read>(2, "x"),   // Races with thread 1's write
+        std::make_shared<Read>(0, "y"),
+        std::make_shared<Write>(2, "y")   // Races with thread 0's read
+    };
+
+    RunOptions options;
+    options.collectAll = true;
+
+    std::cout << "----------------------Running CollectAllRacesExample---------------------------------------" << std::endl;
+    auto result = run(state, program, options);
+    for (const auto& race : result.races) {
+        std::cout << race.toString(state.locations()) << std::endl;
+    }
+
+    std::cout << "-------------------------End of CollectAllRacesExample--------------------------" << std::endl;
+}
+void FixedThreadCountExample() {
+    int threads = 2;
+    std::vector<std::string> locks = {"m"};
+    std::vector<std::string> atomic_objects;
+    std::vector<std::string> shared_locations = {"x"};
+
+    // Picks the StaticVectorClock<2> instantiation for a two-thread program
+    auto detector = makeDetector(threads, locks, atomic_objects, shared_locations);
+    std::vector<std::shared_ptr<Instruction>> program = {
+        std::make_shared<Acquire>(0, "m"),
+        std::make_shared<Write>(0, "x"),
+        std::make_shared<Release>(0, "m"),
+        std::make_shared<Write>(1, "x")   // Thread 1 writes without holding 'm'
+    };
+
+    std::cout << "----------------------Running FixedThreadCountExample---------------------------------------" << std::endl;
+    auto result = detector->run(program);
+    for (const auto& race : result.races) {
+        std::cout << race.toString(detector->locations()) << std::endl;
+    }
+
+    std::cout << "-------------------------End of FixedThreadCountExample--------------------------" << std::endl;
+}
+void ForkJoinExample() {
+    int threads = 1;
+    std::vector<std::string> locks;
+    std::vector<std::string> atomic_objects;
+    std::vector<std::string> shared_locations = {"x"};
+
+    // Only the main thread exists up front; Fork adds the workers
+    auto state = initialVectorClockState(threads, locks, atomic_objects, shared_locations);
+    std::vector<std::shared_ptr<Instruction>> program = {
+        std::make_shared<Write>(0, "x"),
+        std::make_shared<Fork>(0, 1),
+        std::make_shared<Fork>(0, 2),
+        std::make_shared<Read>(1, "x"),   // Ordered after the write by the fork
+        std::make_shared<Write>(2, "x"),  // Races with thread 1's read
+        std::make_shared<Join>(0, 1),
+        std::make_shared<Join>(0, 2),
+        std::make_shared<Write>(0, "x")   // Ordered after both workers by the joins
+    };
+
+    RunOptions options;
+    options.verbose = true;
+    options.collectAll = true;
+
+    std::cout << "----------------------Running ForkJoinExample---------------------------------------" << std::endl;
+    run(state, program, options);
+
+    std::cout << "-------------------------End of ForkJoinExample--------------------------" << std::endl;
+}
+void AddressTraceExample() {
+    int threads = 2;
+
+    // Locations are addresses, shadowed at 4-byte granularity
+    auto state = initialVectorClockState(threads);
+    state.setAddressGranularity(4);
+    std::vector<std::shared_ptr<Instruction>> program = {
+        std::make_shared<Write>(0, 0x7ffd1000),
+        std::make_shared<Write>(1, 0x7ffd1004),  // Next granule: no race
+        std::make_shared<Read>(1, 0x7ffd1002)    // Same granule as thread 0's write
+    };
+
+    std::cout << "----------------------Running AddressTraceExample---------------------------------------" << std::endl;
+    run(state, program, true);
+
+    std::cout << "-------------------------End of AddressTraceExample--------------------------" << std::endl;
+}
+void TreeClockExample() {
+    int threads = 3;
+    std::vector<std::string> locks = {"m"};
+
+    // Thread and lock clocks kept as tree clocks
+    auto detector = makeTreeClockDetector(threads, locks);
+    std::vector<std::shared_ptr<Instruction>> program = {
+        std::make_shared<Acquire>(0, "m"),
+        std::make_shared<Write>(0, "x"),
+        std::make_shared<Release>(0, "m"),
+        std::make_shared<Acquire>(1, "m"),
+        std::make_shared<Write>(1, "x"),   // Ordered after thread 0 through 'm'
+        std::make_shared<Release>(1, "m"),
+        std::make_shared<Read>(2, "x")     // Thread 2 never synchronizes
+    };
+
+    std::cout << "----------------------Running TreeClockExample---------------------------------------" << std::endl;
+    auto result = detector->run(program);
+    for (const auto& race : result.races) {
+        std::cout << race.toString(detector->locations()) << std::endl;
+    }
+
+    std::cout << "-------------------------End of TreeClockExample--------------------------" << std::endl;
+}
+void DeltaLogExample() {
+    int threads = 2;
+
+    // Log only what each event changes, with a full snapshot every 4 events
+    auto state = initialVectorClockState(threads);
+    std::vector<std::shared_ptr<Instruction>> program = {
+        std::make_shared<Acquire>(1, "m"),
+        std::make_shared<Write>(1, "x"),
+        std::make_shared<Release>(1, "m"),
+        std::make_shared<Acquire>(0, "m"),
+        std::make_shared<Read>(0, "x"),    // Ordered after thread 1's write through 'm'
+        std::make_shared<Write>(1, "x")    // Races with thread 0's read
+    };
+
+    std::cout << "----------------------Running DeltaLogExample---------------------------------------" << std::endl;
+    TraceLog log(std::cout, 4);
+    RunOptions options;
+    options.collectAll = true;
+    options.log = &log;
+    run(state, program, options);
+    log.flush();
+
+    std::cout << "-------------------------End of DeltaLogExample--------------------------" << std::endl;
+}
+void SuppressionExample() {
+    int threads = 3;
+
+    auto state = initialVectorClockState(threads);
+    std::vector<std::shared_ptr<Instruction>> program = {
+        std::make_shared<Write>(0, "x"),
+        std::make_shared<Write>(1, "x"),        // Races with thread 0's write
+        std::make_shared<Write>(2, "x"),        // Same type and location: not reported again
+        std::make_shared<Write>(0, "stats.hits"),
+        std::make_shared<Write>(1, "stats.hits") // Benign: suppressed
+    };
+
+    // Report each (type, location) once, and never report races on stats.*
+    Suppressions suppressions;
+    suppressions.add("stats.*");
+    RunOptions options;
+    options.collectAll = true;
+    options.dedupe = RaceKey::TypeLocation;
+    options.suppress = &suppressions;
+
+    std::cout << "----------------------Running SuppressionExample---------------------------------------" << std::endl;
+    auto result = run(state, program, options);
+    for (const auto& race : result.races) {
+        std::cout << race.toString(state.locations()) << std::endl;
+    }
+
+    std::cout << "-------------------------End of SuppressionExample--------------------------" << std::endl;
+}
+void ParallelExample() {
+    int threads = 1;
+    std::vector<std::string> locks = {"m"};
+    std::vector<std::string> atomic_objects;
+    std::vector<std::string> shared_locations = {"x", "y", "z", "w"};
+
+    auto state = initialVectorClockState(threads, locks, atomic_objects, shared_locations);
+    std::vector<std::shared_ptr<Instruction>> program = {
+        std::make_shared<Write>(0, "x"),
+        std::make_shared<Fork>(0, 1),
+        std::make_shared<Fork>(0, 2),
+        std::make_shared<Read>(1, "x"),   // Ordered after the write by the fork
+        std::make_shared<Write>(2, "x"),  // Races with thread 1's read
+        std::make_shared<Acquire>(1, "m"),
+        std::make_shared<Write>(1, "y"),
+        std::make_shared<Release>(1, "m"),
+        std::make_shared<Acquire>(2, "m"),
+        std::make_shared<Read>(2, "y"),   // Ordered after thread 1's write through 'm'
+        std::make_shared<Release>(2, "m"),
+        std::make_shared<Write>(1, "z"),
+        std::make_shared<Read>(2, "z"),   // Races with thread 1's write
+        std::make_shared<Read>(0, "w"),
+        std::make_shared<Read>(1, "w"),
+        std::make_shared<Write>(2, "w"),  // Races with the read-shared "w"
+        std::make_shared<Join>(0, 1),
+        std::make_shared<Join>(0, 2),
+        std::make_shared<Write>(0, "z")   // Ordered after both workers by the joins
+    };
+
+    // Locations are split across 4 workers; the races match a sequential run
+    RunOptions options;
+    options.collectAll = true;
+    VectorClockState sequentialState = state;
+    auto sequential = run(sequentialState, program, options);
+    options.workers = 4;
+
+    std::cout << "----------------------Running ParallelExample---------------------------------------" << std::endl;
+    auto result = run(state, program, options);
+    for (const auto& race : result.races) {
+        std::cout << race.toString(state.locations()) << std::endl;
+    }
+    std::cout << "Same as sequential: " << std::boolalpha << (result.races == sequential.races) << std::endl;
+
+    std::cout << "-------------------------End of ParallelExample--------------------------" << std::endl;
+}
+void PipelineExample() {
+    int threads = 1;
+
+    // A text trace read in batches of 3 events by a reader thread while the
+    // previous batches are checked; later batches introduce new names
+    auto state = initialVectorClockState(threads);
+    std::istringstream trace(
+        "Write(0, x)\n"
+        "Fork(0, 1)\n"
+        "Fork(0, 2)\n"
+        "Read(1, x)\n"       // Ordered after the write by the fork
+        "Write(2, x)\n"      // Races with thread 1's read
+        "Acquire(1, m)\n"
+        "Write(1, y)\n"
+        "Release(1, m)\n"
+        "Write(2, y)\n"      // Thread 2 never acquires 'm': races with thread 1's write
+        "Join(0, 1)\n"
+        "Join(0, 2)\n"
+        "Read(0, y)\n");     // Ordered after both workers by the joins
+    RunOptions options;
+    options.collectAll = true;
+    PipelineOptions pipeline;
+    pipeline.batchSize = 3;
+    // Called on the report thread as each race is found
+    pipeline.onRace = [](const Race&, const std::string& text) {
+        std::cout << "onRace: " << text << std::endl;
+    };
+
+    std::cout << "----------------------Running PipelineExample---------------------------------------" << std::endl;
+    auto result = runTextTracePipelined(state, trace, options, pipeline);
+    std::cout << result.races.size() << " race(s) in " << result.position << " events" << std::endl;
+
+    std::cout << "-------------------------End of PipelineExample--------------------------" << std::endl;
+}
+void OnlineExample() {
+    // Hooks called by the program's own threads as the events happen
+    OnlineDetector detector(3);
+    std::mutex m;
+    int guarded = 0, unguarded = 0;
+    auto worker = [&](int t) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            detector.onAcquire(t, reinterpret_cast<std::uint64_t>(&m));
+            detector.onWrite(t, reinterpret_cast<std::uint64_t>(&guarded));
+            ++guarded;
+            detector.onRelease(t, reinterpret_cast<std::uint64_t>(&m));
+        }
+        detector.onWrite(t, reinterpret_cast<std::uint64_t>(&unguarded));   // No lock held
+        ++unguarded;
+    };
+
+    std::cout << "----------------------Running OnlineExample---------------------------------------" << std::endl;
+    detector.onFork(0, 1);
+    detector.onFork(0, 2);
+    std::thread a(worker, 1), b(worker, 2);
+    a.join();
+    detector.onJoin(0, 1);
+    b.join();
+    detector.onJoin(0, 2);
+    std::cout << detector.races().size() << " race(s), stopped: " << std::boolalpha << detector.stopped() << std::endl;
+
+    std::cout << "-------------------------End of OnlineExample--------------------------" << std::endl;
+}
+
+void OnlineCacheExample() {
+    struct Step {
+        Opcode op;
+        int thread;
+        std::uint64_t address;
+    };
+    const std::uint64_t x = 0x7ffd1000, m = 0x7ffd2000;
+    const std::vector<std::pair<const char*, std::vector<Step>>> cases = {
+        // Thread 0's write collapses the read-shared shadow of x, so its
+        // next read must be checked again and is seen by thread 2's write
+        {"collapse", {
+            {Opcode::Read, 0, x}, {Opcode::Read, 1, x},
+            {Opcode::Release, 1, m}, {Opcode::Acquire, 0, m},
+            {Opcode::Read, 0, x}, {Opcode::Write, 0, x}, {Opcode::Read, 0, x},
+            {Opcode::Write, 2, x}
+        }},
+        // Thread 1's racy write replaces thread 0's in the shadow, so thread
+        // 0 repeating its write in the same epoch races again
+        {"repeat after a remote race", {
+            {Opcode::Write, 0, x}, {Opcode::Write, 1, x}, {Opcode::Write, 0, x}
+        }},
+    };
+
+    RunOptions options;
+    options.collectAll = true;
+
+    std::cout << "----------------------Running OnlineCacheExample---------------------------------------" << std::endl;
+    for (const auto& [name, steps] : cases) {
+        // The same events offline, and online with and without the access cache
+        auto state = initialVectorClockState(3);
+        std::vector<std::shared_ptr<Instruction>> program;
+        OnlineDetector cached(3, options), uncached(3, options, 8, false);
+        for (const Step& step : steps) {
+            for (OnlineDetector* detector : {&cached, &uncached}) {
+                switch (step.op) {
+                case Opcode::Read: detector->onRead(step.thread, step.address); break;
+                case Opcode::Write: detector->onWrite(step.thread, step.address); break;
+                case Opcode::Acquire: detector->onAcquire(step.thread, step.address); break;
+                default: detector->onRelease(step.thread, step.address); break;
+                }
+            }
+            switch (step.op) {
+            case Opcode::Read: program.push_back(std::make_shared<Read>(step.thread, step.address)); break;
+            case Opcode::Write: program.push_back(std::make_shared<Write>(step.thread, step.address)); break;
+            case Opcode::Acquire: program.push_back(std::make_shared<Acquire>(step.thread, addressName(step.address))); break;
+            default: program.push_back(std::make_shared<Release>(step.thread, addressName(step.address))); break;
+            }
+        }
+        auto result = run(state, program, options);
+
+        auto races = [](const std::vector<Race>& found, const SymbolTable& names) {
+            std::string text;
+            for (const auto& race : found) {
+                text += race.toString(names) + " ";
+            }
+            return text;
+        };
+        const std::string expected = races(result.races, state.locations());
+        std::cout << name << ": " << expected << std::endl;
+        std::cout << "  cached matches: " << std::boolalpha << (races(cached.races(), cached.raceLocations()) == expected)
+                  << ", uncached matches: " << (races(uncached.races(), uncached.raceLocations()) == expected) << std::endl;
+    }
+
+    std::cout << "-------------------------End of OnlineCacheExample--------------------------" << std::endl;
+}
+
+
 
 
 
@@ -142,5 +494,16 @@ int main() {
     SolveWriteWriteRaceExample();
     WriteReadRaceExample();
     SolveWriteReadRaceExample();
+    CollectAllRacesExample();
+    FixedThreadCountExample();
+    ForkJoinExample();
+    AddressTraceExample();
+    TreeClockExample();
+    DeltaLogExample();
+    SuppressionExample();
+    ParallelExample();
+    PipelineExample();
+    OnlineExample();
+    OnlineCacheExample();
 
 }
\ No newline at end of file